@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include <util/time.h>
+
+/// Prevents the compiler from optimizing away a computed value.
+template<typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/** Runs `body` repeatedly for roughly `minDuration` and prints the average time per iteration.
+ *  @param bytesPerIteration if non-zero, throughput is printed as well
+ */
+template<typename Body>
+void runBenchmark(const std::string &name, Body &&body, size_t bytesPerIteration = 0, Duration minDuration = 200ms) {
+
+    // warm up caches & branch predictors
+    body();
+
+    size_t iterations = 0, batch = 1;
+    TimePoint start = Clock::now(), end;
+    do {
+        for(size_t i=0; i<batch; ++i)
+            body();
+        iterations += batch;
+        batch *= 2;
+        end = Clock::now();
+    } while(end - start < minDuration);
+
+    double nsPerIteration = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+    std::cout << std::left << std::setw(56) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << nsPerIteration << " ns/iter";
+    if(bytesPerIteration > 0)
+        std::cout << std::setw(10) << bytesPerIteration / nsPerIteration * 1e9 / (1<<20) << " MiB/s";
+    std::cout << std::endl;
+}
+
+// Benchmark suites, each one is implemented in its own file
+void benchmarkSerde();
+void benchmarkScheduler();
+void benchmarkPathfinding();
+void benchmarkMoveGeneration();
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+/** One bit per tile of a map, in the same row-major order as Field.
+ *  Used for occupancy: set operations, counting and iterating over set bits
+ *  all process 64 tiles per word operation.
+ */
+class Bitboard {
+    public:
+
+    Bitboard() : Bitboard(glm::ivec2(0)) {}
+    explicit Bitboard(glm::ivec2 size) :
+        words((static_cast<size_t>(size.x) * size.y + 63) / 64, 0),
+        _size(size)
+    {}
+
+    glm::ivec2 size() const {
+        return _size;
+    }
+    bool inBounds(const glm::ivec2 &position) const {
+        return static_cast<unsigned>(position.x) < static_cast<unsigned>(_size.x) &&
+               static_cast<unsigned>(position.y) < static_cast<unsigned>(_size.y);
+    }
+    size_t index(const glm::ivec2 &position) const {
+        assert(inBounds(position));
+        return static_cast<size_t>(position.y) * _size.x + position.x;
+    }
+    glm::ivec2 position(size_t index) const {
+        return glm::ivec2(static_cast<int>(index % _size.x), static_cast<int>(index / _size.x));
+    }
+
+    bool test(const glm::ivec2 &position) const {
+        size_t i = index(position);
+        return (words[i/64] >> (i%64)) & 1;
+    }
+    /// @returns false for positions outside of the board
+    bool testOr(const glm::ivec2 &position, bool defaultValue) const {
+        return inBounds(position) ? test(position) : defaultValue;
+    }
+    void set(const glm::ivec2 &position) {
+        size_t i = index(position);
+        words[i/64] |= uint64_t(1) << (i%64);
+    }
+    void reset(const glm::ivec2 &position) {
+        size_t i = index(position);
+        words[i/64] &= ~(uint64_t(1) << (i%64));
+    }
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    /// @returns number of set bits
+    int count() const {
+        int result = 0;
+        for(uint64_t word : words)
+            result += __builtin_popcountll(word);
+        return result;
+    }
+    bool none() const {
+        for(uint64_t word : words)
+            if(word)
+                return false;
+        return true;
+    }
+    bool any() const {
+        return !none();
+    }
+
+    Bitboard &operator|=(const Bitboard &other) {
+        assert(words.size() == other.words.size());
+        for(size_t i=0; i<words.size(); ++i)
+            words[i] |= other.words[i];
+        return *this;
+    }
+    Bitboard &operator&=(const Bitboard &other) {
+        assert(words.size() == other.words.size());
+        for(size_t i=0; i<words.size(); ++i)
+            words[i] &= other.words[i];
+        return *this;
+    }
+    /// Clears all bits which are set in other
+    Bitboard &subtract(const Bitboard &other) {
+        assert(words.size() == other.words.size());
+        for(size_t i=0; i<words.size(); ++i)
+            words[i] &= ~other.words[i];
+        return *this;
+    }
+
+    /// Calls callback(position) for every set bit, in row-major order.
+    template<typename Callback>
+    void forEach(Callback &&callback) const {
+        for(size_t w=0; w<words.size(); ++w)
+            for(uint64_t word = words[w]; word != 0; word &= word - 1)
+                callback(position(w*64 + __builtin_ctzll(word)));
+    }
+
+    const std::vector<uint64_t> &data() const {
+        return words;
+    }
+
+    private:
+    std::vector<uint64_t> words;
+    glm::ivec2 _size;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/field.h>
+#include <engine/terrain.h>
+
+/** Precomputed terrain-only movement costs between tiles of one map, ignoring units.
+ *  Since units can only block paths, these are lower bounds of the real cost of moving
+ *  from one tile to another, usable as an admissible A* heuristic or to quickly rule out
+ *  tiles which are out of range.
+ *
+ *  Small maps store the exact cost between every pair of tiles (2 bytes per pair).
+ *  Larger maps store exact costs from a few landmark tiles only and derive lower bounds
+ *  from the triangle inequality (ALT): |d(L,a) - d(L,b)| <= d(a,b) for every landmark L.
+ */
+class DistanceOracle {
+    public:
+
+    static constexpr size_t maxAllPairsTiles = 1024;
+    static constexpr int landmarkCount = 8;
+
+    DistanceOracle() = default;
+    explicit DistanceOracle(const Field<uint16_t> &movementCosts);
+
+    glm::ivec2 size() const;
+    /// @returns true if lowerBound() returns exact costs
+    bool isExact() const;
+
+    /// @returns lower bound of the cost of moving from `from` to `to` (exact if isExact())
+    int lowerBound(const glm::ivec2 &from, const glm::ivec2 &to) const;
+
+    private:
+    size_t index(const glm::ivec2 &position) const;
+
+    glm::ivec2 _size = glm::ivec2(0);
+    size_t tileCount = 0;
+    // cheapest single step on this map, for the fallback taxicab bound
+    int minStepCost = 0;
+
+    // [from * tileCount + to]
+    std::vector<uint16_t> allPairs;
+    // [landmark * tileCount + tile]
+    std::vector<int> landmarkDistances;
+};
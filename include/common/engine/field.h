@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
 #include <vector>
 #include <glm/vec2.hpp>
 #include <glm/vector_relational.hpp>
@@ -8,15 +12,46 @@
 #include <network/rxbuffer.h>
 #include <network/txbuffer.h>
 
+/** Contiguous view of one row of a Field.
+ *  Only valid as long as the field isn't resized or reassigned.
+ */
+template<typename T>
+class FieldRow {
+    public:
+    FieldRow(T *first, int width) : first(first), width(width) {}
+
+    T *begin() const {return first;}
+    T *end() const {return first + width;}
+    int size() const {return width;}
+    T &operator[](int x) const {
+        assert(x >= 0 && x < width);
+        return first[x];
+    }
+
+    private:
+    T *first;
+    int width;
+};
+
+/** 2D grid of values, stored in a single allocation in row-major order 
+ *  (all of row y=0 first, then row y=1 etc.), which is also the order used on the wire.
+ *  Loops which visit the whole field should iterate over y in the outer loop, 
+ *  or just use begin()/end() or row().
+ */
 template<typename T>
 class Field {
 
+    // std::vector<bool> isn't contiguous, use e.g. uint8_t instead
+    static_assert(!std::is_same_v<T, bool>, "Field<bool> is not supported");
+
     private:
-    std::vector<std::vector<T>> values;
+    std::vector<T> values;
+    glm::ivec2 _size;
 
     public:
     Field(glm::ivec2 size, const T &filler) :
-        values(size.x, std::vector<T>(size.y, filler))  
+        values(static_cast<size_t>(size.x) * size.y, filler),
+        _size(size)
     {}
     Field(glm::ivec2 size) : 
         Field(size, T{})
@@ -26,17 +61,18 @@ class Field {
     {}
     
     glm::ivec2 size() const {
-        return glm::ivec2(
-            static_cast<int>(values.size()),
-            static_cast<int>(values.front().size())
-        );
+        return _size;
     }
-    const T &get(const glm::ivec2 &position) const {
+    /// @returns position of the element at given position within data()
+    size_t index(const glm::ivec2 &position) const {
         assert(inBounds(position));
-        return values[position.x][position.y];
+        return static_cast<size_t>(position.y) * _size.x + position.x;
+    }
+    const T &get(const glm::ivec2 &position) const {
+        return values[index(position)];
     }
     T &get(const glm::ivec2 &position) {
-        return const_cast<T &>(const_cast<const Field *>(this)->get(position));
+        return values[index(position)];
     }
     const T &getOr(const glm::ivec2 &position, const T& defaultValue) const {
         if(inBounds(position))
@@ -48,13 +84,13 @@ class Field {
         return const_cast<T &>(const_cast<const Field *>(this)->getOr(position, defaultValue));
     }
     void set(const glm::ivec2 &position, const T &value) {
-        assert(inBounds(position));
-        values[position.x][position.y] = std::move(value);
+        values[index(position)] = value;
+    }
+    void set(const glm::ivec2 &position, T &&value) {
+        values[index(position)] = std::move(value);
     }
     void fill(const T &value) {
-        for(int x=0; x<size().x; ++x)
-            for(int y=0; y<size().y; ++y)
-                set(glm::ivec2(x,y), value);
+        std::fill(values.begin(), values.end(), value);
     }
     bool trySet(const glm::ivec2 &position, const T &value) {
         if(inBounds(position)) {
@@ -65,27 +101,56 @@ class Field {
         }
     }
     bool inBounds(const glm::ivec2 &position) const {
-        return glm::all(glm::greaterThanEqual(position, glm::ivec2(0))) &&
-               glm::all(glm::lessThan(position, size()));
+        // negative coordinates wrap around to huge unsigned values
+        return static_cast<unsigned>(position.x) < static_cast<unsigned>(_size.x) &&
+               static_cast<unsigned>(position.y) < static_cast<unsigned>(_size.y);
+    }
+
+    FieldRow<T> row(int y) {
+        assert(y >= 0 && y < _size.y);
+        return FieldRow<T>(values.data() + static_cast<size_t>(y) * _size.x, _size.x);
+    }
+    FieldRow<const T> row(int y) const {
+        assert(y >= 0 && y < _size.y);
+        return FieldRow<const T>(values.data() + static_cast<size_t>(y) * _size.x, _size.x);
     }
+
+    /// All elements in row-major order
+    T *data() {return values.data();}
+    const T *data() const {return values.data();}
+    typename std::vector<T>::iterator begin() {return values.begin();}
+    typename std::vector<T>::iterator end() {return values.end();}
+    typename std::vector<T>::const_iterator begin() const {return values.begin();}
+    typename std::vector<T>::const_iterator end() const {return values.end();}
 };
 
 template<typename T>
 RxBuffer &operator>>(RxBuffer &rx, Field<T> &field) {
     auto width = rx.read<uint32_t>();
     auto height = rx.read<uint32_t>();
+
+    // every element takes at least one byte, so don't let a bogus size make us allocate gigabytes
+    if(static_cast<uint64_t>(width) * height > rx.size())
+        throw std::out_of_range("");
+
     field = Field<T>(glm::ivec2(width, height));
-    for(uint32_t y=0; y<height; ++y)
-        for(uint32_t x=0; x<width; ++x)
-            field.set(glm::ivec2(x,y), rx.read<T>());
+    // wire format is row by row, same as the storage order
+    if constexpr (isBulkSerializable<T>)
+        readArray(rx, field.data(), static_cast<size_t>(width) * height);
+    else
+        for(auto &value : field)
+            rx >> value;
     return rx;
 }
 
 template<typename T>
 TxBuffer &operator<<(TxBuffer &tx, const Field<T> &field) {
-    tx << field.size().x << field.size().y;
-    for(int y=0; y<field.size().y; ++y)
-        for(int x=0; x<field.size().x; ++x)
-            tx << field.get(glm::ivec2(x,y));
+    auto size = field.size();
+    tx << size.x << size.y;
+    if constexpr (isBulkSerializable<T>)
+        writeArray(tx, field.data(), static_cast<size_t>(size.x) * size.y);
+    else
+        for(const auto &value : field)
+            tx << value;
     return tx;
 }
\ No newline at end of file
@@ -1,27 +1,45 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <vector>
-#include <set>
 #include <mutex>
 
 #include <glm/vec2.hpp>
 
+#include <engine/bitboard.h>
+#include <engine/distanceoracle.h>
 #include <engine/field.h>
 #include <engine/map.h>
 #include <engine/unit.h>
+#include <engine/unitpool.h>
 #include <engine/move.h>
-
-struct IVec2Comparator {
-    bool operator()(const glm::ivec2 &lhs, const glm::ivec2 &rhs) const {
-        if(lhs.x < rhs.x) return true;
-        else if(lhs.x > rhs.x) return false;
-        else return lhs.y < rhs.y;
-    }
-};
+#include <engine/pathfinding.h>
+#include <engine/threatmap.h>
+#include <util/scheduler.h>
 
 typedef int64_t GameID;
 
+/** Everything a move changed which can't be derived from the state after it, so that
+ *  Game::unmakeMove can restore the previous state exactly.
+ *  Unbounded parts (e.g. movement points replenished at the end of turn) are kept on stacks
+ *  owned by the game, which is why moves must be unmade in the reverse order they were made in.
+ */
+struct MoveUndo {
+    MoveType type;
+    uint8_t previousPlayer;
+    // moved or attacking unit
+    UnitHandle unit = NO_UNIT;
+    glm::ivec2 from;
+    int movementPoints;
+    // attacked unit, restored if it was killed
+    UnitHandle target = NO_UNIT;
+    UnitTypeID targetType;
+    int targetHealth;
+    // number of entries pushed onto the game's undo stacks
+    uint16_t savedEntries = 0;
+};
+
 class Game : public MoveAcceptor {
 
     friend RxBuffer &operator>>(RxBuffer &rx, Game &game);
@@ -32,42 +50,152 @@ class Game : public MoveAcceptor {
     Game();
     Game(GameID id, const Map &map, const std::vector<std::string> &playerUsernames);
 
+    /// Copy of the game without any caches or undo history, much cheaper than copying the whole game to simulate moves.
+    Game stateCopy() const;
+
     int playerCount() const;
     const std::string &currentPlayer() const;
+    int currentPlayerIndex() const;
     GameID id() const;
-    std::shared_ptr<const Unit> unitAt(const glm::ivec2 &position) const;
-    std::shared_ptr<Unit> unitAt(const glm::ivec2 &position);
 
-    bool isTileOccupied(const glm::ivec2 &position);
-    int adjacentTileMovementCost(const glm::ivec2 &srcTile, const glm::ivec2 &dstTile);
+    /** Monotonically increasing number identifying the current state of the game.
+     *  Bumped by every state-changing method of Game (but not by modifying units or terrain directly),
+     *  so anything derived from the state can be cached for as long as the version stays the same.
+     *  Versions are local to each Game instance and are not serialized.
+     */
+    uint64_t version() const;
+    /// @returns copy of the unit at given position, if there is one
+    std::optional<Unit> unitAt(const glm::ivec2 &position) const;
+    /// @returns handle of the unit at given position (index into unitPool) or NO_UNIT
+    UnitHandle unitHandleAt(const glm::ivec2 &position) const;
+
+    bool isTileOccupied(const glm::ivec2 &position) const;
+    int adjacentTileMovementCost(const glm::ivec2 &srcTile, const glm::ivec2 &dstTile) const;
     int getPlayerIndex(const std::string &username);
 
-    void spawn(std::shared_ptr<Unit> unit);
+    void spawn(const Unit &unit);
     void endTurn();
     void forceSurrender(const std::string &username);
 
     bool didPlayerWin(const std::string &username);
     bool didPlayerLoose(const std::string &username);
-
-    std::map<glm::ivec2, glm::ivec2, IVec2Comparator> findReachableTiles(const Unit &u);
-
+    int unitCount(int player) const;
+
+    /// Tiles occupied by any unit
+    const Bitboard &occupancy() const;
+    /// Tiles occupied by units of given player
+    const Bitboard &occupancy(int player) const;
+
+    /** Finds all tiles the unit can move to this turn, along with the cheapest paths.
+     *  Results for units in the game are cached until a move affects them, so repeated queries are cheap.
+     *  The result is stored in memory owned by the game and stays valid until the next call 
+     *  or state change, so callers which need it for longer should copy it.
+     */
+    ReachableTiles findReachableTiles(const Unit &u) const;
+    ReachableTiles findReachableTiles(UnitHandle unit) const;
+    /// Same as above, but uses the given scratch (e.g. to run searches from multiple threads).
+    ReachableTiles findReachableTiles(const Unit &u, PathfindingScratch &scratch) const;
+
+    /// Finds reachable tiles of all units of given player, in row-major order of their positions.
+    void findReachableTiles(int player, ReachabilityBatch &outRanges) const;
+    /** Same as above, but searches in parallel. Cached results are reused, but new ones aren't cached.
+     *  The game must not be modified until the call returns.
+     */
+    void findReachableTiles(int player, ReachabilityBatch &outRanges, Scheduler &scheduler) const;
+
+    /** Finds the cheapest path of the unit to the target tile this turn, from the unit's position to the target (inclusive).
+     *  Uses the cached reachable tiles if there are any, otherwise an A* search which stops at the target.
+     *  @returns false if the target can't be reached, outPath is left empty then
+     */
+    bool findPath(const Unit &u, const glm::ivec2 &target, std::vector<glm::ivec2> &outPath) const;
+    bool findPath(UnitHandle unit, const glm::ivec2 &target, std::vector<glm::ivec2> &outPath) const;
+    /** Answers many path queries at once, replacing contents of `outPaths` (path i answers query i).
+     *  Units with many queries get their reachable tiles searched (and cached) once instead of running A* for each query.
+     */
+    void findPaths(const std::vector<PathQuery> &queries, PathBatch &outPaths) const;
+
+    /// Tiles each player can attack during their next turn, brought up to date on every call
+    const ThreatMap &threats() const;
+
+    /** Terrain-only movement costs between tiles (see DistanceOracle).
+     *  Shared with the map the game was created from, games received over the network compute it on first use.
+     *  Only valid for as long as the terrain stays the same, see onTerrainChanged().
+     */
+    const DistanceOracle &distances() const;
+
+    /** Must be called after modifying terrain: recomputes movement costs and drops everything derived from them,
+     *  including the distance oracle (a stale one could overestimate distances and make pathfinding miss shortest paths).
+     */
+    void onTerrainChanged();
+
+    /** Checks whether the current player can make the move, without modifying the game.
+     *  Never throws, so it's cheap to reject lots of invalid moves (e.g. during search or from misbehaving clients).
+     */
+    MoveStatus validateMove(const Move &m) const;
+    /** Checks a sequence of moves as if they were made one after another, without modifying the game.
+     *  @param outFailedMove set to the index of the first invalid move, if there is one
+     */
+    MoveStatus validateMoves(const std::vector<Move> &moves, size_t *outFailedMove = nullptr) const;
+    /// Makes the move if it is valid, otherwise leaves the game unchanged. Never throws.
+    MoveStatus tryMakeMove(const Move &m);
+    /// Makes the move, or throws InvalidMoveError (leaving the game unchanged) if it is invalid
     void makeMove(const Move &) override;
 
-    // we don't store a Map because maybe the terrain will get modified during the game
-    Field<const TerrainType *> terrain;
+    /// Same as tryMakeMove(m), but when the move is valid also records how to undo it
+    MoveStatus tryMakeMove(const Move &m, MoveUndo &outUndo);
+    /// Same as makeMove(m), but also records how to undo the move
+    void makeMove(const Move &m, MoveUndo &outUndo);
+    /** Restores the state from before the move `undo` was recorded for, including unit handles.
+     *  Moves must be unmade in the reverse order they were made in, with no other changes to the game in between.
+     *  Doesn't allocate, so make/unmake is much cheaper than copying the game to try out moves.
+     */
+    void unmakeMove(const MoveUndo &undo);
+    /** Makes all moves, or none of them if any is invalid (in which case the game is left as it was).
+     *  @param outFailedMove set to the index of the first invalid move, if there is one
+     */
+    MoveStatus tryMakeMoves(const std::vector<Move> &moves, size_t *outFailedMove = nullptr);
+
+    // we don't store a Map because maybe the terrain will get modified during the game,
+    // onTerrainChanged() has to be called after every such modification
+    Field<TerrainID> terrain;
+    // movement cost of every tile, derived from terrain by onTerrainChanged()
+    Field<uint16_t> movementCosts;
 
     // there can only be one unit per terrain tile
-    Field<std::shared_ptr<Unit>> units;
+    Field<UnitHandle> units;
+    UnitPool unitPool;
 
     private:
 
-    void moveUnitOneTile(const glm::ivec2 &from, const glm::ivec2 &to);
+    // makes a move which already passed validateMove, recording how to undo it if `outUndo` isn't null
+    void applyMove(const Move &m, MoveUndo *outUndo);
+    void setOccupied(const glm::ivec2 &position, int player);
+    void setUnoccupied(const glm::ivec2 &position, int player);
 
     int _currentPlayer = 0;
     GameID _id;
+    uint64_t _version = 0;
 
-    std::vector<std::set<glm::ivec2, IVec2Comparator>> playerUnitPositions;
+    Bitboard allUnits;
+    std::vector<Bitboard> playerUnits;
     std::vector<std::string> playerUsernames;
+
+    // undo stacks, see MoveUndo
+    struct RemovedUnit {
+        UnitHandle handle;
+        UnitTypeID type;
+    };
+    struct SavedPoints {
+        int movementPoints, actionPoints;
+    };
+    std::vector<RemovedUnit> removedUnits;
+    std::vector<SavedPoints> savedPoints;
+    std::vector<MoveUndo> batchUndo;
+
+    mutable PathfindingScratch pathfindingScratch;
+    mutable ReachabilityCache reachabilityCache;
+    mutable std::shared_ptr<const DistanceOracle> distanceOracle;
+    mutable ThreatMap threatMap;
 };
 
 int taxicabDistance(const glm::ivec2 &srcTile, const glm::ivec2 &dstTile);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include <engine/distanceoracle.h>
 #include <engine/field.h>
 #include <engine/terrain.h>
 #include <engine/unit.h>
@@ -10,9 +12,13 @@ struct Map : ContentType<Map> {
 
     Field<const TerrainType *> terrain;
     std::vector<std::vector<Unit>> startingUnits;
+    /// Terrain-only movement costs, computed when the map is registered (null until then)
+    std::shared_ptr<const DistanceOracle> distances;
 
     int playerCount() const;
 
     Map();
     Map(const std::string &id, glm::ivec2 size, int playerCount, const TerrainType *filler);
+
+    void onRegistered();
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <glm/vec2.hpp>
 
 #include <network/serde_macros.h>
+#include <util/smallvector.h>
 #include <network/rxbuffer.h>
 #include <network/txbuffer.h>
 #include <engine/unit.h>
@@ -18,9 +19,17 @@ enum class MoveType : uint32_t {
     COUNT = 5
 };
 
+/** A single action of a player.
+ *  Arguments are stored inline for all moves except long unit paths, so creating,
+ *  copying and decoding moves usually doesn't allocate.
+ *  On the wire, MOVE_UNIT paths are encoded as the first tile followed by 2 bits per step.
+ */
 struct Move {
+    /// Number of arguments stored without allocating (a path of 8 tiles)
+    static constexpr size_t inlineArgs = 16;
+
     MoveType type;
-    std::vector<int32_t> args;
+    SmallVector<int32_t, inlineArgs> args;
 
     static Move moveUnit(const std::vector<glm::ivec2> &unitPath);
     static Move attackUnit(const Unit &attacker, const Unit &target);
@@ -48,7 +57,28 @@ class RecordingMoveAcceptorProxy : public MoveAcceptor {
     void makeMove(const Move &) override;
 };
 
+/// Result of checking whether a move can be made, see Game::validateMove
+enum class MoveStatus : uint8_t {
+    OK = 0,
+    MALFORMED,
+    DISCONTINUOUS_PATH,
+    NO_UNIT,
+    NOT_OWNED,
+    NO_MOVEMENT_POINTS,
+    DESTINATION_OCCUPIED,
+    OUT_OF_BOUNDS,
+    NO_TARGET,
+    NO_ACTION_POINTS,
+    OUT_OF_RANGE,
+    FRIENDLY_TARGET,
+    NOT_IMPLEMENTED
+};
+
+/// @returns human readable description of the status
+const char *moveStatusMessage(MoveStatus status);
+
 class InvalidMoveError : public std::runtime_error {
     public:
     InvalidMoveError(const std::string &what) : std::runtime_error(what) {}
+    InvalidMoveError(MoveStatus status) : std::runtime_error(moveStatusMessage(status)) {}
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/move.h>
+#include <engine/pathfinding.h>
+#include <engine/unitpool.h>
+
+class Game;
+
+/** Compact description of a legal move, see MoveGenerator.
+ *  Unit paths aren't stored, MOVE_UNIT moves only refer to the destination among the
+ *  unit's reachable tiles kept by the generator, so listing moves doesn't allocate.
+ */
+struct GeneratedMove {
+    MoveType type;
+    /// Moving or attacking unit
+    UnitHandle unit = NO_UNIT;
+    /// ATTACK_UNIT: the attacked unit
+    UnitHandle target = NO_UNIT;
+    /// MOVE_UNIT: index of the destination among the unit's reachable tiles (a path handle, see MoveGenerator::path())
+    uint32_t destination = 0;
+};
+
+/** Lists all legal moves of the current player:
+ *  - MOVE_UNIT to every tile each unit can reach this turn (except the tile it's standing on),
+ *  - ATTACK_UNIT of every enemy unit within the attacker's attackRange, for units with action points left,
+ *  - END_TURN and SURRENDER.
+ *
+ *  Reachable tiles of all units are kept until the next call of generate(), which is how
+ *  generated moves are turned into paths. Every ply of a search needs its own generator.
+ */
+class MoveGenerator {
+    public:
+
+    /// Replaces contents of `outMoves` with legal moves of the current player in given state
+    void generate(const Game &game, std::vector<GeneratedMove> &outMoves);
+
+    /// MOVE_UNIT: @returns the tile the unit moves to
+    glm::ivec2 destination(const GeneratedMove &move) const;
+    /// MOVE_UNIT: replaces contents of `outPath` with the cheapest path to the destination
+    void path(const GeneratedMove &move, std::vector<glm::ivec2> &outPath) const;
+    /// @returns the move in the form accepted by Game, the state must be the same as during generate()
+    Move toMove(const Game &game, const GeneratedMove &move) const;
+
+    private:
+    ReachableTiles reachableTiles(UnitHandle unit) const;
+
+    ReachabilityBatch reachability;
+    // index into `reachability` for every unit handle
+    std::vector<uint16_t> rangeOfUnit;
+    mutable std::vector<glm::ivec2> pathScratch;
+};
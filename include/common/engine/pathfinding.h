@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/bitboard.h>
+#include <engine/distanceoracle.h>
+#include <engine/field.h>
+#include <engine/terrain.h>
+#include <engine/unitpool.h>
+
+/// A tile reachable by a unit, along with the cheapest way to get there.
+struct ReachableTile {
+    glm::ivec2 position;
+    /// Previous tile on the cheapest path (the starting tile is its own predecessor)
+    glm::ivec2 predecessor;
+    int movementPointsLeft;
+};
+
+/** Result of a reachability search: all reachable tiles, sorted in row-major order.
+ *  This is a view, it's only valid until the storage it was obtained from is reused
+ *  (see PathfindingScratch and Game::findReachableTiles()).
+ */
+class ReachableTiles {
+    public:
+
+    ReachableTiles() = default;
+    ReachableTiles(const ReachableTile *first, size_t count) : first(first), count(count) {}
+
+    const ReachableTile *begin() const {return first;}
+    const ReachableTile *end() const {return first + count;}
+    size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+
+    /// @returns the tile or nullptr if the position isn't reachable
+    const ReachableTile *find(const glm::ivec2 &position) const;
+    bool contains(const glm::ivec2 &position) const;
+
+    /// Replaces contents of `outPath` with the cheapest path from the starting tile to `destination` (inclusive).
+    void path(const glm::ivec2 &destination, std::vector<glm::ivec2> &outPath) const;
+
+    private:
+    const ReachableTile *first = nullptr;
+    size_t count = 0;
+};
+
+/** Reusable working memory for reachability searches on one map.
+ *  After the first few searches no memory is allocated anymore.
+ *  Every thread running searches concurrently needs its own scratch.
+ *  Copies start out empty, since the contents are not part of any game state.
+ */
+class PathfindingScratch {
+    public:
+
+    PathfindingScratch() = default;
+    PathfindingScratch(const PathfindingScratch &) {}
+    PathfindingScratch &operator=(const PathfindingScratch &) {return *this;}
+
+    /** Finds all tiles a unit can reach with Dijkstra's algorithm over a bucket queue (Dial's algorithm).
+     *  Stepping from one tile to an adjacent one costs the movement cost of both tiles, and a unit
+     *  may take another step as long as it has any movement points left.
+     *  @param blocked tiles which can't be entered (the starting tile itself may be blocked, e.g. by the unit)
+     *  @returns view of the result, valid until the next search using this scratch
+     */
+    ReachableTiles findReachableTiles(
+        const Field<uint16_t> &movementCosts,
+        const Bitboard &blocked,
+        const glm::ivec2 &start,
+        int movementPoints
+    );
+
+    /** Finds the cheapest path from `start` to `target` with A*, following the same movement rules
+     *  as findReachableTiles(), but stopping as soon as the target is reached.
+     *  @param distances lower bounds of terrain costs, used as the heuristic. They are never smaller than
+     *      the plain taxicab distance times the cheapest step cost, so A* expands at most as many tiles as with it.
+     *  @returns false if the target can't be reached, outPath is left empty then
+     */
+    bool findPath(
+        const Field<uint16_t> &movementCosts,
+        const Bitboard &blocked,
+        const DistanceOracle &distances,
+        const glm::ivec2 &start,
+        const glm::ivec2 &target,
+        int movementPoints,
+        std::vector<glm::ivec2> &outPath
+    );
+
+    private:
+    // starts a new search, growing the arrays if needed
+    void prepare(glm::ivec2 mapSize);
+
+    // indexed by tile, entries are only valid if epoch[tile] == currentEpoch
+    std::vector<int> distance;
+    std::vector<uint32_t> predecessor, epoch;
+    uint32_t currentEpoch = 0;
+
+    // bucket i holds tiles at distance d with d % buckets.size() == i
+    std::vector<std::vector<uint32_t>> buckets;
+    struct HeapEntry {
+        int estimate, distance;
+        uint32_t tile;
+    };
+    // binary heap ordered by estimated total cost, used by A*
+    std::vector<HeapEntry> heap;
+    std::vector<ReachableTile> result;
+};
+
+/** Sets bits of all tiles whose occupancy could change the result of the search: 
+ *  reachable tiles, and tiles the unit could have stepped onto if they were free.
+ */
+void markDependencies(const ReachableTiles &tiles, Bitboard &outDependencies);
+
+/// Request for the path of one unit to one tile, see Game::findPaths().
+struct PathQuery {
+    UnitHandle unit;
+    glm::ivec2 target;
+};
+
+/// Multiple paths stored back to back, see Game::findPaths().
+class PathBatch {
+    public:
+
+    void clear();
+    void add(const std::vector<glm::ivec2> &path);
+
+    size_t size() const;
+    /// @returns whether path i was found
+    bool found(size_t i) const;
+    /// Tiles of path i, from the unit's position to the target
+    const glm::ivec2 *begin(size_t i) const;
+    const glm::ivec2 *end(size_t i) const;
+
+    private:
+    std::vector<glm::ivec2> tiles;
+    // path i is tiles[offsets[i], offsets[i+1]) (empty if not found)
+    std::vector<uint32_t> offsets = {0};
+};
+
+/** Reachable tiles of many units packed into one contiguous array, see Game::findReachableTiles(int, ...).
+ *  Also owns the working memory of the search threads, so reusing a batch avoids allocations.
+ */
+class ReachabilityBatch {
+    public:
+
+    size_t size() const;
+    UnitHandle unit(size_t i) const;
+    /// Reachable tiles of the i-th unit, valid until the batch is reused
+    ReachableTiles operator[](size_t i) const;
+
+    private:
+    friend class Game;
+
+    struct Span {
+        uint32_t worker, offset, count;
+    };
+    // results of one search thread, before they are packed
+    struct Worker {
+        PathfindingScratch scratch;
+        std::vector<ReachableTile> tiles;
+    };
+
+    /// Prepares for searching `units` with up to `workerCount` threads
+    void prepare(size_t workerCount);
+    /// Appends a result computed by given worker (called concurrently by different workers)
+    void add(size_t worker, size_t i, const ReachableTiles &result);
+    /// Moves all results into `tiles`, in unit order
+    void pack();
+
+    std::vector<UnitHandle> units;
+    std::vector<ReachableTile> tiles;
+    // range i is tiles[offsets[i], offsets[i+1])
+    std::vector<uint32_t> offsets;
+
+    std::vector<Span> spans;
+    std::vector<Worker> workers;
+};
+
+/** Reachable tiles of individual units, kept until a change of the game state could affect them.
+ *  A result stays valid for as long as the unit keeps its position and movement points and none of
+ *  the tiles the search looked at (reachable tiles and tiles adjacent to them) changes occupancy.
+ *  The owner has to report every occupancy change with invalidate().
+ */
+class ReachabilityCache {
+    public:
+
+    /// @returns the cached result or an empty optional if the unit has to be searched again
+    std::optional<ReachableTiles> find(UnitHandle unit, const glm::ivec2 &position, int movementPoints) const;
+    /// Copies a search result into the cache, @returns view of the copy
+    ReachableTiles store(UnitHandle unit, const glm::ivec2 &position, int movementPoints, const ReachableTiles &tiles, glm::ivec2 mapSize);
+
+    /// Drops all results which depend on the occupancy of given tile
+    void invalidate(const glm::ivec2 &tile);
+    void clear();
+
+    private:
+    struct Entry {
+        bool valid = false;
+        glm::ivec2 position;
+        int movementPoints;
+        std::vector<ReachableTile> tiles;
+        // tiles whose occupancy the result depends on
+        Bitboard dependencies;
+    };
+    // indexed by unit handle, memory of invalidated entries is reused
+    std::vector<Entry> entries;
+};
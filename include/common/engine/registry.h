@@ -20,6 +20,14 @@ class Registry {
     std::vector<const T *> objects;
     std::map<std::string, int> idToNumericID;
 
+    // T is still incomplete when Registry<T> gets instantiated (by ContentType<T>), 
+    // so the table can't be a plain member and has to be looked up lazily
+    template<typename U = T>
+    static typename U::StatTable &statTable() {
+        static typename U::StatTable table;
+        return table;
+    }
+
     public:
 
     void add(T &object) {
@@ -28,6 +36,14 @@ class Registry {
         object.numericID = numericID;
         idToNumericID[object.id] = numericID;
         objects.push_back(&object);
+        statTable().add(object);
+        object.onRegistered();
+    }
+
+    /// Stats of all registered objects in dense arrays indexed by numeric ID (see ContentType::StatTable)
+    template<typename U = T>
+    const typename U::StatTable &stats() const {
+        return statTable<U>();
     }
 
     bool contains(int numericID) const {
@@ -68,6 +84,17 @@ class ContentType {
 
     ContentType(const std::string &id) : id(id) {}
 
+    /// Called by Registry::add(), content types can hide this to precompute data once their contents are final.
+    void onRegistered() {}
+
+    /** Struct of arrays holding the stats of all objects in the registry, for loops which only need
+     *  one or two numbers per object. Content types can hide this with their own table.
+     *  Stats are copied when an object is registered, so they must not change afterwards.
+     */
+    struct StatTable {
+        void add(const Derived &) {}
+    };
+
     static Registry<Derived> registry;
 };
 
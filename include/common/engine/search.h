@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/game.h>
+#include <engine/movegenerator.h>
+#include <util/scheduler.h>
+#include <util/time.h>
+
+/// How much work a single SearchEngine::findMove() may do.
+struct SearchLimits {
+    /// Time the whole search may take, measured from when findMove() is called
+    Duration timeBudget = 200ms;
+    /// Number of independent trees searched in parallel, each one on its own copy of the game
+    /// (at most one per scheduler thread; trees which can't start right away get less time)
+    int threadCount = 1;
+    /// Each thread stops after this many playouts, even if it has time left
+    size_t maxPlayouts = SIZE_MAX;
+    /// Moves made after leaving the tree before the position is scored
+    int playoutLength = 12;
+};
+
+/** Chooses moves for the current player with Monte Carlo tree search (UCT), parallelized at the root.
+ *
+ *  Every thread grows its own tree from its own copy of the game, walking it with make/unmake
+ *  and expanding nodes with MoveGenerator. Playouts are cut off after a few moves and scored by
+ *  material (remaining health of everyone's units), so they don't need to reach the end of the game.
+ *  At the end visit counts of the root's children are summed over all trees and the most visited move wins.
+ *
+ *  A search only reads the game it was given, so the caller may search a copy and keep playing on the original.
+ *  Different searches may run concurrently on the same scheduler.
+ */
+class SearchEngine {
+    public:
+
+    explicit SearchEngine(Scheduler &scheduler);
+
+    /** @param seed makes the search reproducible (given the same amount of work per thread)
+     *  @returns the best move found for the current player, never SURRENDER
+     */
+    Move findMove(const Game &game, const SearchLimits &limits, uint64_t seed);
+
+    private:
+    // Move leading to a node, compact because nodes are plentiful: paths are looked up again when the move is made
+    struct Edge {
+        MoveType type;
+        UnitHandle unit, target;
+        glm::ivec2 destination;
+    };
+    struct Node {
+        Edge edge;
+        uint32_t firstChild = 0, childCount = 0;
+        bool expanded = false;
+        uint32_t visits = 0;
+        // sum of playout results, from the searching player's point of view
+        double reward = 0;
+    };
+    struct Tree;
+
+    static void search(const Game &game, const SearchLimits &limits, TimePoint deadline, uint64_t seed, Tree &tree);
+
+    Scheduler &scheduler;
+};
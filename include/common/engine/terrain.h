@@ -1,11 +1,30 @@
 #pragma once 
 
+#include <cstdint>
 #include <string>
+#include <vector>
+#include <engine/field.h>
 #include <engine/registry.h>
 
+/// Numeric ID of a TerrainType, used to store terrain compactly
+typedef uint8_t TerrainID;
+
 class TerrainType : public ContentType<TerrainType> {
     public:
     int movementCost = 10;
 
     TerrainType(const std::string &id);
-};
\ No newline at end of file
+
+    struct StatTable {
+        std::vector<uint16_t> movementCost;
+        int maxMovementCost = 0;
+
+        /// @throws std::length_error if there are too many terrain types to fit into a TerrainID
+        void add(const TerrainType &type);
+    };
+};
+
+/// @returns numeric IDs of all tiles
+Field<TerrainID> terrainIDField(const Field<const TerrainType *> &terrain);
+/// @returns movement costs of all tiles
+Field<uint16_t> movementCostField(const Field<TerrainID> &terrain);
\ No newline at end of file
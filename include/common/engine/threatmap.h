@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/bitboard.h>
+#include <engine/field.h>
+#include <engine/pathfinding.h>
+#include <engine/unit.h>
+#include <engine/unitpool.h>
+
+class Game;
+
+/** Which tiles each player can attack during their next turn, and how hard.
+ *
+ *  A unit threatens every tile within its attack range of any tile it can reach with
+ *  a full turn's worth of movement points (other units block movement as usual).
+ *  For every player and target unit type the map holds the expected damage a unit of
+ *  that type would take on each tile if all threatening units attacked it with all
+ *  of their action points.
+ *
+ *  Contributions of individual units are remembered, so after a move only the units
+ *  which moved, died or had their movement range changed by the move are recomputed.
+ */
+class ThreatMap {
+    public:
+
+    ThreatMap() = default;
+    ThreatMap(int playerCount, glm::ivec2 mapSize);
+
+    /// Expected damage dealt by `player` to a unit of type `target`, per tile
+    const Field<int> &damage(int player, const UnitType &target) const;
+    /// Number of `player`'s units able to attack each tile
+    const Field<int> &attackers(int player) const;
+
+    /// Marks units whose threatened tiles depend on the occupancy of `tile` for recomputation
+    void invalidate(const glm::ivec2 &tile);
+    /// Recomputes contributions of units which changed since the last update
+    void update(const Game &game);
+
+    private:
+    struct Contribution {
+        bool applied = false, dirty = false;
+        // the unit this was computed for
+        UnitTypeID type;
+        int player;
+        glm::ivec2 position;
+        // threatened tiles, and tiles whose occupancy affects them
+        std::vector<uint32_t> tiles;
+        Bitboard dependencies;
+    };
+
+    void apply(const Contribution &contribution, int sign);
+    void compute(const Game &game, UnitHandle unit, Contribution &outContribution);
+
+    glm::ivec2 mapSize = glm::ivec2(0);
+    int playerCount = 0;
+    // [player * UnitType::registry.size() + target type]
+    std::vector<Field<int>> damageFields;
+    std::vector<Field<int>> attackerFields;
+
+    // indexed by unit handle
+    std::vector<Contribution> contributions;
+    PathfindingScratch scratch;
+    Bitboard threatened;
+};
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <glm/vec2.hpp>
 #include <engine/registry.h>
 #include <network/rxbuffer.h>
 #include <network/txbuffer.h>
 
-// workaround for not being able to #include <common/engine/game.h>
-class Game;
+/// Numeric ID of a UnitType, used to store units compactly
+typedef uint8_t UnitTypeID;
+constexpr UnitTypeID NO_UNIT_TYPE = UINT8_MAX;
 
 class UnitType : public ContentType<UnitType> {
     public:
@@ -25,6 +28,21 @@ class UnitType : public ContentType<UnitType> {
         attackRange = 1;
 
     UnitType(const std::string &id);
+
+    struct StatTable {
+        std::vector<int> maxHealth, armor, evasion, movementPointsPerTurn, actionPointsPerTurn,
+                         attackDamage, attackPenetration, attackAccuracy, attackRange;
+
+        /// @returns damage dealt by a single attack, same as ::attackDamage()
+        int damage(UnitTypeID attacker, UnitTypeID target) const;
+
+        /// @throws std::length_error if there are too many unit types to fit into a UnitTypeID
+        void add(const UnitType &type);
+
+        private:
+        // [attacker * number of types + target]
+        std::vector<int> damageMatrix;
+    };
 };
 
 struct Unit {
@@ -37,11 +55,13 @@ struct Unit {
     Unit(UnitType &type, int player, glm::ivec2 position);
 
     bool isAlive() const;
-    void update(Game &game);
 
     void attack(Unit &other);
 };
 
+/// @returns damage dealt by a single attack
+int attackDamage(const UnitType &attacker, const UnitType &target);
+
 RxBuffer &operator>>(RxBuffer &rx, Unit &unit);
 TxBuffer &operator<<(TxBuffer &tx, const Unit &unit);
 
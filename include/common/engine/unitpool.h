@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include <engine/unit.h>
+
+/// Compact reference to a unit stored in a UnitPool.
+typedef uint16_t UnitHandle;
+constexpr UnitHandle NO_UNIT = UINT16_MAX;
+
+/** Storage for all units of a game, as a struct of arrays indexed by UnitHandle.
+ *
+ *  Loops which only need one or two stats of every unit (e.g. resetting movement points
+ *  at the end of turn) read the corresponding arrays sequentially, without refcounting
+ *  or chasing pointers. Handles of removed units are reused by later units.
+ *  Unit (the struct) is still used to pass around copies of a single unit.
+ */
+class UnitPool {
+    public:
+
+    static constexpr size_t maxUnits = NO_UNIT;
+
+    /// @throws std::length_error if the pool is full
+    UnitHandle add(const Unit &unit);
+    void remove(UnitHandle handle);
+    /** Undoes the most recent remove(), bringing the unit back under the same handle.
+     *  Stats of removed units are left in place, so only the type needs to be given back.
+     */
+    void restore(UnitHandle handle, UnitTypeID type);
+    void clear();
+
+    bool contains(UnitHandle handle) const;
+    /// @returns copy of the unit's stats
+    Unit get(UnitHandle handle) const;
+
+    /// Handles range over [0, capacity()), use contains() to skip removed units.
+    size_t capacity() const;
+    size_t size() const;
+
+    // parallel arrays, indexed by handle (type == NO_UNIT_TYPE for removed units), 
+    // stats of the unit's type are in UnitType::registry.stats()
+    std::vector<UnitTypeID> type;
+    std::vector<uint8_t> player;
+    std::vector<int> health, movementPoints, actionPoints;
+    std::vector<glm::ivec2> position;
+
+    private:
+    std::vector<UnitHandle> freeHandles;
+};
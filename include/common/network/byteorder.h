@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/** Bulk conversion between host and network byte order.
+ *  
+ *  Each function converts `count` consecutive values of the given width in place
+ *  (the conversion is its own inverse, so the same function is used in both directions).
+ *  `data` doesn't need to be aligned. On x86 the conversion uses SSSE3/AVX2 shuffles 
+ *  when the CPU supports them; on big endian hosts these functions do nothing.
+ */
+void convertByteOrder16(void *data, size_t count);
+void convertByteOrder32(void *data, size_t count);
+void convertByteOrder64(void *data, size_t count);
+
+/// True for types whose wire format is just their bytes in network byte order (these can be (de)serialized in bulk).
+template<typename T>
+constexpr bool isBulkSerializable = 
+    (std::is_integral_v<T> || std::is_floating_point_v<T>) && !std::is_same_v<T, bool> &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+/// Dispatches to the appropriate convertByteOrder function based on the size of T.
+template<typename T>
+void convertByteOrder(T *values, size_t count) {
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    if constexpr (sizeof(T) == 2) convertByteOrder16(values, count);
+    if constexpr (sizeof(T) == 4) convertByteOrder32(values, count);
+    if constexpr (sizeof(T) == 8) convertByteOrder64(values, count);
+}
@@ -1,12 +1,22 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include <network/txbuffer.h>
 #include <network/rxbuffer.h>
+#include <network/ringbuffer.h>
 #include <util/time.h>
 
+/** A complete message including its size prefix, ready to be sent as-is.
+ *  Frames are immutable and reference counted, so one frame can be encoded once 
+ *  and then sent to any number of sockets, from any thread.
+ *  Sockets queue a reference to the frame instead of copying it (see MessageSocket::sendFrame()).
+ */
+typedef std::shared_ptr<const TxBuffer> SharedFrame;
+
 class MessageSocket {
 
     public:
@@ -19,18 +29,125 @@ class MessageSocket {
      */
     MessageSocket(int sockfd);
     ~MessageSocket();
+
+    /// Receives all data currently available on the socket, then flushes outgoing data.
     void update();
 
+    /// Sends as much buffered outgoing data as the socket accepts without blocking.
+    void flush();
+
+    /// Size of the receive buffer, which is also the upper limit for the size of a received message.
+    static constexpr size_t receiveBufferCapacity = 64*1024;
+
     /// @returns true if connection is active, false if the other side disconnected.
     bool isConnected() const;
+
+    /** @returns true if a complete message was received.
+     *  @throw ProtocolError if the next message is too large to ever fit in the receive buffer
+     */
     bool hasMessage();
+
+    /** Removes the next message from the receive buffer and returns a view of it.
+     *  The message is not copied: the returned RxBuffer points directly into the receive buffer
+     *  and stays valid until the next call to update() or onReceived().
+     */
     RxBuffer receiveMessage();
     void sendMessage(const TxBuffer &message);
+
+    /** Starts a new outgoing message directly in the send buffer.
+     *  The caller serializes the message into the returned buffer and then calls endMessage(),
+     *  which fills in the size prefix. No temporary buffer or copy is needed.
+     */
+    TxBuffer &beginMessage();
+
+    /// Finishes the message started by beginMessage().
+    void endMessage();
+
+    /// Serializes all arguments, in order, as a single message (see beginMessage()).
+    template<typename... Parts>
+    void send(const Parts &...parts) {
+        TxBuffer &message = beginMessage();
+        (message << ... << parts);
+        endMessage();
+    }
+
+    /// Serializes all arguments, in order, as a single message which can be sent with sendFrame().
+    template<typename... Parts>
+    static SharedFrame encodeFrame(const Parts &...parts) {
+        auto frame = std::make_shared<TxBuffer>();
+        *frame << static_cast<uint32_t>(0);
+        (*frame << ... << parts);
+        patchFrameSize(*frame);
+        return frame;
+    }
+
+    /** Sends a message previously encoded with encodeFrame().
+     *  The frame isn't copied into the send buffer: the socket keeps a reference to it until it has been
+     *  sent (with a single sendmsg() along with any other queued output).
+     */
+    void sendFrame(SharedFrame frame);
+
     void waitForMessage(const Duration &timeout);
 
+    /// @returns the underlying BSD socket file descriptor (ownership is retained).
+    int fd() const;
+
+    /// @returns true if there is outgoing data which could not be sent yet.
+    bool hasPendingOutput() const;
+
+    /** Enables or disables socket syscalls in update() and flush() (enabled by default).
+     *  With direct I/O disabled the owner of the socket performs the actual I/O itself 
+     *  (e.g. through io_uring) and reports the results through the methods below.
+     */
+    void setDirectIO(bool enabled);
+
+    /** Appends data received from the socket to the receive buffer.
+     *  @param numBytes must not exceed receiveCapacity()
+     */
+    void onReceived(const void *data, size_t numBytes);
+
+    /// @returns Number of bytes which can currently be received without overflowing the receive buffer.
+    size_t receiveCapacity() const;
+
+    /// @returns number of bytes of outgoing data waiting to be sent
+    size_t pendingOutputSize() const;
+    /** Copies the first bytes of outgoing data waiting to be sent, without removing them
+     *  (for owners doing their own I/O from a buffer of their own, e.g. registered with io_uring).
+     *  @returns number of copied bytes, at most `maxBytes`
+     */
+    size_t copyPendingOutput(uint8_t *dst, size_t maxBytes) const;
+
+    /// Removes the specified number of bytes (which were successfully sent) from the outgoing data.
+    void onSent(size_t numBytes);
+
+    /// Marks the connection as closed by the other side.
+    void onRemoteClosed();
+
     private:
+    /** Part of the outgoing data, either a shared frame or a run of bytes at the front of txBuffer.
+     *  Segments are sent in order, so messages built in txBuffer and shared frames can be interleaved.
+     */
+    struct OutputSegment {
+        /// empty for bytes from txBuffer
+        SharedFrame frame;
+        /// offset of the first unsent byte within the frame (bytes from txBuffer are popped once sent instead)
+        size_t offset;
+        size_t size;
+    };
+
+    static void patchFrameSize(TxBuffer &frame);
+    /// Queues the last `numBytes` bytes of txBuffer for sending
+    void queueBuffered(size_t numBytes);
+
     TxBuffer txBuffer;
-    RxBuffer rxBuffer;
+    std::deque<OutputSegment> output;
+    size_t outputSize = 0;
+    RingBuffer rxBuffer{receiveBufferCapacity};
     int sockfd;
     bool connected = true;
+    bool directIO = true;
+
+    // offset of the size prefix of the message being built, relative to txBuffer.ptr()
+    size_t messageStart;
+    bool buildingMessage = false;
 };
\ No newline at end of file
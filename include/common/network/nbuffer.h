@@ -18,6 +18,19 @@ class NetworkBuffer {
      */
     void pushNetworkOrder(const void *ptr, size_t numBytes);
 
+    /** Appends `numBytes` zero bytes at the end of the buffer.
+     *  @returns Pointer to the appended bytes, valid until the buffer is modified again.
+     */
+    uint8_t *grow(size_t numBytes);
+
+    /** Overwrites already appended data (without byte order conversion).
+     *  @param offset offset relative to the first byte in the buffer
+     */
+    void overwriteNetworkOrder(size_t offset, const void *ptr, size_t numBytes);
+
+    /// Removes bytes from the back of the buffer, so that it contains only the first `numBytes` bytes.
+    void truncate(size_t numBytes);
+
     /// @returns Pointer to the first byte in the buffer.
     const uint8_t *ptr() const;
 
@@ -27,9 +40,10 @@ class NetworkBuffer {
     /// Removes the specified number of bytes from the front of the buffer.
     void pop(size_t numBytes);
 
-    /// equivalent to std::vector::shrink_to_fit
+    /// Discards already popped bytes from the underlying storage (the allocation is kept for reuse).
     void compact();
 
+    /// Compacts the buffer if popped bytes take up at least half of the storage.
     void maybeCompact();
 
     size_t getPosition() const;
@@ -109,6 +109,10 @@ class NFProtocolEntity {
     NFProtocolEntity(int sockfd);
 
     void runNetworkEvents();
+
+    /// Sends queued outgoing messages without waiting for incoming data.
+    void flushNetworkEvents();
+
     void halt();
     bool isRunning() const;
     void setTimeout(const Duration &timeoutDuration = 5s);
@@ -125,6 +129,13 @@ class NFProtocolEntity {
     void sendGameJoinError(GameJoinError);
     void sendFullSync(const Game &);
     void sendIncrementalSync(const GameIncrementalSync &);
+
+    /** Encodes a sync message once, so that it can be broadcast 
+     *  to many connections with sendFrame() without serializing or copying it again.
+     */
+    static SharedFrame encodeIncrementalSync(const GameIncrementalSync &);
+    static SharedFrame encodeFullSync(const Game &);
+    void sendFrame(const SharedFrame &);
     
     virtual void onInit();
     virtual void onUpdate(const Duration &dt);
@@ -145,6 +156,9 @@ class NFProtocolEntity {
     virtual void onTimeout();
     virtual void onDisconnect() = 0;
 
+    const MessageSocket &socket() const;
+    MessageSocket &socket();
+
     protected:
     std::set<MessageType> whitelist, blacklist;
 
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/** Fixed-capacity FIFO byte queue for data received from the network.
+ *  
+ *  Where possible the storage is a "magic ring": the same physical pages are mapped
+ *  twice, back to back, so both the readable and the writable region are always 
+ *  contiguous in memory, no matter where they wrap around. This allows handing out
+ *  pointers into the buffer (e.g. to recv() or as a message view) without copying.
+ *  If the mirrored mapping can't be created, a plain buffer is used instead, which
+ *  moves the (usually small) unread remainder to the front when space runs out.
+ *  
+ *  The buffer never reallocates, so pointers obtained from ptr() stay valid until 
+ *  the data they point to is overwritten by a subsequent write.
+ */
+class RingBuffer {
+    public:
+
+    /// @param minCapacity capacity of the buffer, rounded up to a multiple of the page size
+    RingBuffer(size_t minCapacity);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    size_t capacity() const;
+
+    /// @returns Number of bytes stored in the buffer.
+    size_t size() const;
+
+    /// @returns Pointer to the first byte in the buffer, followed by size()-1 more contiguous bytes.
+    const uint8_t *ptr() const;
+
+    /// Removes the specified number of bytes from the front of the buffer.
+    void pop(size_t numBytes);
+
+    /// @returns Number of bytes which can still be written into the buffer.
+    size_t writableSize() const;
+
+    /** @returns Pointer to writableSize() bytes of contiguous free space at the back of the buffer.
+     *  Data written there becomes part of the buffer after a call to commit().
+     */
+    uint8_t *writePtr();
+
+    /// Appends `numBytes` bytes previously written at writePtr() to the buffer.
+    void commit(size_t numBytes);
+
+    /** Appends a copy of the specified data at the back of the buffer.
+     *  @throw std::length_error if there is not enough free space
+     */
+    void push(const void *data, size_t numBytes);
+
+    private:
+    uint8_t *base = nullptr;
+    size_t _capacity;
+    bool mirrored = false;
+
+    // mirrored: monotonic stream offsets (position in buffer = offset % capacity)
+    // not mirrored: offsets from the start of the buffer
+    size_t head = 0, tail = 0;
+};
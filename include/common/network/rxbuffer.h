@@ -6,18 +6,44 @@
 #include <set>
 #include <map>
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
 
-#include <network/nbuffer.h>
+#include <network/byteorder.h>
 
-/** Buffer for data received from the network.
+
+/** Read cursor over data received from the network.
  *  
- *  Stores data internally in network byte order. Automatically converts
+ *  Data is stored in network byte order. Automatically converts
  *  to host byte order when typed data is read from the buffer.
+ * 
+ *  RxBuffer does not own the data it reads from (usually a message still sitting
+ *  in the receive buffer of a MessageSocket), so it's cheap to create and pass around.
+ *  The viewed data must outlive the RxBuffer.
  */
-class RxBuffer : public NetworkBuffer {
+class RxBuffer {
 
     public:
 
+    /// Creates an empty buffer.
+    RxBuffer();
+
+    /// Creates a view of `numBytes` bytes starting at `data`. The data is not copied.
+    RxBuffer(const uint8_t *data, size_t numBytes);
+
+    /// @returns Pointer to the first unread byte.
+    const uint8_t *ptr() const;
+
+    /// @returns Number of unread bytes.
+    size_t size() const;
+
+    /// Skips the specified number of bytes.
+    void pop(size_t numBytes);
+
+    size_t getPosition() const;
+    void setPosition(size_t newPosition);
+
     template<typename T> T read() {
         T result;
         operator>>(*this, result);
@@ -35,9 +61,14 @@ class RxBuffer : public NetworkBuffer {
     template<typename T> 
     T peek(size_t addr=0) {
         T result;
-        peek<T>(0,result);
+        peek<T>(addr,result);
         return result;
     }
+
+    private:
+    const uint8_t *data;
+    size_t dataSize;
+    size_t position = 0;
 };
 
 
@@ -53,13 +84,37 @@ RxBuffer &operator>>(RxBuffer &rx, float &result);
 RxBuffer &operator>>(RxBuffer &rx, double &result);
 RxBuffer &operator>>(RxBuffer &rx, std::string &result);
 
+/** Reads `count` values at once: one bounds check, one memcpy and a vectorized byte order conversion.
+ *  @throw std::out_of_range if the buffer doesn't contain enough data
+ */
+template<typename T>
+void readArray(RxBuffer &rx, T *values, size_t count) {
+    static_assert(isBulkSerializable<T>);
+    if(count > rx.size() / sizeof(T))
+        throw std::out_of_range("");
+    // memcpy requires valid pointers even for 0 bytes, and an empty vector's data() may be null
+    if(count == 0)
+        return;
+    memcpy(values, rx.ptr(), count*sizeof(T));
+    convertByteOrder(values, count);
+    rx.pop(count*sizeof(T));
+}
+
 template<typename T>
 RxBuffer &operator>>(RxBuffer &rx, std::vector<T> &result) {
     uint32_t vectorSize = rx.read<uint32_t>();
     result.clear();
-    result.reserve(vectorSize);
-    for(uint32_t i=0; i<vectorSize; ++i)
-        result.push_back(rx.read<T>());
+    if constexpr (isBulkSerializable<T>) {
+        // check before resizing, so that a bogus size can't make us allocate gigabytes
+        if(vectorSize > rx.size() / sizeof(T))
+            throw std::out_of_range("");
+        result.resize(vectorSize);
+        readArray(rx, result.data(), vectorSize);
+    } else {
+        result.reserve(std::min<size_t>(vectorSize, rx.size()));
+        for(uint32_t i=0; i<vectorSize; ++i)
+            result.push_back(rx.read<T>());
+    }
     return rx;
 }
 
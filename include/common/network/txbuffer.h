@@ -6,8 +6,10 @@
 #include <set>
 #include <map>
 #include <string>
+#include <cstring>
 
 #include <network/nbuffer.h>
+#include <network/byteorder.h>
 
 /** Buffer for data sent over the network.
  *  
@@ -29,11 +31,26 @@ TxBuffer &operator<<(TxBuffer &tx, double value);
 
 TxBuffer &operator<<(TxBuffer &tx, const std::string &value);
 
+/// Appends `count` values at once: one memcpy and a vectorized byte order conversion in the buffer.
+template<typename T>
+void writeArray(TxBuffer &tx, const T *values, size_t count) {
+    static_assert(isBulkSerializable<T>);
+    // memcpy requires valid pointers even for 0 bytes, and an empty vector's data() may be null
+    if(count == 0)
+        return;
+    auto bytes = tx.grow(count*sizeof(T));
+    memcpy(bytes, values, count*sizeof(T));
+    convertByteOrder(reinterpret_cast<T *>(bytes), count);
+}
+
 template<typename T>
 TxBuffer &operator<<(TxBuffer &tx, const std::vector<T> &value) {
     tx << static_cast<uint32_t>(value.size());
-    for(const auto &element : value)
-        tx << element;
+    if constexpr (isBulkSerializable<T>)
+        writeArray(tx, value.data(), value.size());
+    else
+        for(const auto &element : value)
+            tx << element;
     return tx;
 }
 
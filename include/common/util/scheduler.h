@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Work-stealing task scheduler backed by a fixed set of worker threads.
+ *
+ *  Every worker owns a deque of tasks. Tasks spawned from a worker thread go to the back
+ *  of its own deque and are executed LIFO (good cache locality for recursively split work),
+ *  idle workers steal from the front of other workers' deques. Tasks spawned from other
+ *  threads are distributed round-robin.
+ *
+ *  Tasks run through spawn() must not throw (an escaping exception terminates the program,
+ *  just like with std::thread); use TaskGroup to propagate exceptions to the waiting thread.
+ *
+ *  This class is thread-safe.
+ */
+class Scheduler {
+    public:
+
+    typedef std::function<void()> Task;
+
+    /** Starts the worker threads.
+     *  @param threadCount number of worker threads, 0 = one per hardware thread
+     *  @param pinThreads if true, worker i is pinned to CPU core i (modulo the number of cores)
+     */
+    explicit Scheduler(int threadCount = 0, bool pinThreads = false);
+
+    /// Runs all remaining tasks, then stops the worker threads.
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    void spawn(Task task);
+
+    /** Executes one queued task on the calling thread, if there is any.
+     *  Lets threads which wait for tasks help out instead of blocking.
+     *  @returns true if a task was executed
+     */
+    bool runPendingTask();
+
+    int threadCount() const;
+
+    /** @returns index of the calling thread's worker in [0, threadCount()), or threadCount() for other threads.
+     *  Useful for indexing per-thread working memory.
+     */
+    size_t currentWorkerIndex() const;
+
+    private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    bool popTask(size_t firstVictim, Task &outTask);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> queuedTasks = 0, nextWorker = 0;
+
+    // used to put idle workers to sleep
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<int> sleepingWorkers = 0;
+    bool stopping = false;
+};
+
+/** A set of tasks which can be waited for as a whole.
+ *  The first exception thrown by any of the tasks is rethrown by wait().
+ *
+ *  Tasks are queued in the group itself and the scheduler only receives stubs which run the next
+ *  one of them, so the waiting thread can help with the group's tasks without picking up unrelated
+ *  (possibly long-running) tasks of other groups. Stubs which find the group's queue empty do nothing.
+ *
+ *  Tasks may be added from any thread, wait() should only be called by the group's owner.
+ */
+class TaskGroup {
+    public:
+
+    explicit TaskGroup(Scheduler &scheduler);
+
+    /// Waits for remaining tasks, exceptions are discarded.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(Scheduler::Task task);
+
+    /// Blocks until all tasks have finished, executing the group's queued tasks in the meantime.
+    void wait();
+
+    private:
+    // shared with the stubs given to the scheduler, which may outlive the group
+    struct State {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Scheduler::Task> tasks;
+        size_t pendingTasks = 0;
+        std::exception_ptr error;
+    };
+
+    /// Runs one of the queued tasks (the newest one if `newest`, otherwise the oldest one), if there is any
+    static bool runQueuedTask(State &state, bool newest);
+
+    Scheduler &scheduler;
+    std::shared_ptr<State> state;
+};
+
+/** Calls body(i) for every i in [begin, end), split into chunks of at least `grainSize` indices
+ *  executed in parallel. The calling thread participates and the call returns once all indices
+ *  have been processed. Exceptions thrown by `body` are rethrown.
+ */
+template<typename Body>
+void parallelFor(Scheduler &scheduler, size_t begin, size_t end, Body &&body, size_t grainSize = 1) {
+    if(begin >= end)
+        return;
+
+    // a few chunks per thread, so that stealing can even out uneven chunks
+    size_t count = end - begin;
+    size_t chunkSize = std::max(grainSize, (count + 4*scheduler.threadCount() - 1) / (4*scheduler.threadCount()));
+
+    TaskGroup group(scheduler);
+    for(size_t chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+        size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+        group.run([&body, chunkBegin, chunkEnd]{
+            for(size_t i=chunkBegin; i<chunkEnd; ++i)
+                body(i);
+        });
+    }
+
+    // the first chunk runs right here
+    std::exception_ptr error;
+    try {
+        for(size_t i=begin; i<std::min(end, begin + chunkSize); ++i)
+            body(i);
+    } catch(...) {
+        error = std::current_exception();
+    }
+
+    group.wait();
+    if(error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+/** Vector which stores up to N elements inline and only allocates when it grows beyond that.
+ *  Meant for small, short-lived arrays of plain values (e.g. move arguments), so it only
+ *  supports trivially copyable element types and a subset of std::vector's interface.
+ */
+template<typename T, size_t N>
+class SmallVector {
+
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only supports trivially copyable types");
+
+    public:
+
+    SmallVector() = default;
+    SmallVector(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+    }
+    SmallVector(const SmallVector &other) {
+        assign(other.begin(), other.end());
+    }
+    SmallVector(SmallVector &&other) {
+        *this = std::move(other);
+    }
+    SmallVector &operator=(const SmallVector &other) {
+        if(this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+    SmallVector &operator=(SmallVector &&other) {
+        if(this == &other)
+            return *this;
+        if(other.heap) {
+            // steal the allocation
+            heap = std::move(other.heap);
+            _size = other._size;
+            _capacity = other._capacity;
+            other._size = 0;
+            other._capacity = N;
+        } else {
+            assign(other.begin(), other.end());
+            other.clear();
+        }
+        return *this;
+    }
+
+    size_t size() const {return _size;}
+    bool empty() const {return _size == 0;}
+    size_t capacity() const {return _capacity;}
+    /// @returns true if elements are stored inline (nothing is allocated)
+    bool isInline() const {return !heap;}
+
+    T *data() {return heap ? heap.get() : inlineElements;}
+    const T *data() const {return heap ? heap.get() : inlineElements;}
+    T *begin() {return data();}
+    T *end() {return data() + _size;}
+    const T *begin() const {return data();}
+    const T *end() const {return data() + _size;}
+
+    T &operator[](size_t i) {
+        assert(i < _size);
+        return data()[i];
+    }
+    const T &operator[](size_t i) const {
+        assert(i < _size);
+        return data()[i];
+    }
+    T &back() {
+        assert(_size > 0);
+        return data()[_size-1];
+    }
+    const T &back() const {
+        assert(_size > 0);
+        return data()[_size-1];
+    }
+
+    void push_back(const T &value) {
+        if(_size == _capacity)
+            reserve(_capacity * 2);
+        data()[_size++] = value;
+    }
+    void clear() {
+        _size = 0;
+    }
+    /// New elements are value-initialized
+    void resize(size_t newSize) {
+        reserve(newSize);
+        if(newSize > _size)
+            std::fill(data() + _size, data() + newSize, T{});
+        _size = newSize;
+    }
+    void reserve(size_t newCapacity) {
+        if(newCapacity <= _capacity)
+            return;
+        std::unique_ptr<T[]> newElements(new T[newCapacity]);
+        std::memcpy(newElements.get(), data(), _size * sizeof(T));
+        heap = std::move(newElements);
+        _capacity = newCapacity;
+    }
+
+    template<typename It>
+    void assign(It first, It last) {
+        clear();
+        reserve(std::distance(first, last));
+        for(; first != last; ++first)
+            data()[_size++] = *first;
+    }
+
+    bool operator==(const SmallVector &other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+    bool operator!=(const SmallVector &other) const {
+        return !(*this == other);
+    }
+
+    private:
+    std::unique_ptr<T[]> heap;
+    size_t _size = 0, _capacity = N;
+    T inlineElements[N];
+};
@@ -13,4 +13,4 @@ TxBuffer &operator<<(TxBuffer &, const Version &);
 RxBuffer &operator>>(RxBuffer &, Version &);
 
 /// Used to check if client & server are compatible
-constexpr Version applicationVersion{0,1,0};
\ No newline at end of file
+constexpr Version applicationVersion{0,2,0};
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <engine/search.h>
+#include <util/scheduler.h>
+#include <util/time.h>
+#include <gamemanager.h>
+#include <usermanager.h>
+
+/// Settings of the built-in AI players, see BotManager.
+struct BotConfig {
+    /// How long a player looking for a random opponent waits before bots take the free seats, 0 = never
+    Duration seatDelay = 15s;
+    /// Threads shared by all bots
+    int threadCount = 1;
+    /// Work done for every move of a bot
+    SearchLimits limits;
+};
+
+/** Built-in AI players, seated in games of players who have waited too long for an opponent.
+ *
+ *  Bots don't have connections. They reserve a username in UserManager, join games through GameManager
+ *  and publish their moves to the game's MoveJournal, just like connection handlers do.
+ *  Moves are chosen with SearchEngine on a Scheduler of their own with a fixed number of threads,
+ *  separate from the reactor threads, so no number of bot games can starve connections of people.
+ *  Each search gets its full time budget once it starts running: when there are more bots than
+ *  threads, bots respond later instead of playing worse.
+ *
+ *  A bot leaves its game once the game is decided for it or no people are left in it.
+ *
+ *  This class is thread-safe, except for configure().
+ */
+class BotManager {
+    public:
+
+    BotManager(UserManager &users, GameManager &games);
+    /// Waits for bots which are thinking, then makes all bots leave (the game & user managers must still be alive)
+    ~BotManager();
+
+    /// Starts the bot threads, must be called once before any bots are seated
+    void configure(const BotConfig &config);
+    const BotConfig &config() const;
+
+    /// Fills the free seats of the game with bots, unless it has already started
+    void fillGame(GameID id);
+
+    private:
+    struct Bot {
+        std::string username;
+        GameHandle game;
+        uint64_t seed;
+        // a think() is queued, further notifications can be ignored
+        std::atomic<bool> scheduled = false;
+        std::atomic<bool> left = false;
+    };
+
+    void schedule(const std::shared_ptr<Bot> &bot);
+    void think(const std::shared_ptr<Bot> &bot);
+    void leave(Bot &bot);
+    /// @returns true if any of the players is not a bot (called while holding the game mutex)
+    bool hasPeople(const std::vector<std::string> &players);
+
+    UserManager &users;
+    GameManager &games;
+    BotConfig _config;
+    std::unique_ptr<Scheduler> scheduler;
+    // every think() runs in this group, so that they can all be waited for before shutting down
+    std::unique_ptr<TaskGroup> thinking;
+    std::atomic<bool> stopping = false;
+    std::atomic<uint64_t> nextBotID = 1;
+
+    // lock order: game mutex -> mutex
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<Bot>> bots;
+};
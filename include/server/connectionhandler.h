@@ -1,6 +1,45 @@
 #pragma once
 
-#include <atomic>
+#include <memory>
 #include <server.h>
+#include <network/message.h>
+#include <util/time.h>
 
-void handleConnection(int sockfd, Server *server);
\ No newline at end of file
+class NFServerProtocolEntity;
+
+/** Server side of a single client connection.
+ *  This class is NOT thread-safe: a connection is owned by exactly one reactor 
+ *  worker thread, which is the only thread allowed to call its methods.
+ */
+class ConnectionHandler {
+    public:
+
+    /** @param sockfd socket obtained from accept(), ownership is transferred to the handler
+     *  @param server server this connection belongs to
+     *  @param directIO if false, the caller performs socket I/O itself (see MessageSocket::setDirectIO)
+     *  @param wakeup called from any thread when the game state changes; should schedule an update() of this connection
+     */
+    ConnectionHandler(int sockfd, Server &server, bool directIO = true, GameListener wakeup = {});
+    ~ConnectionHandler();
+
+    ConnectionHandler(const ConnectionHandler &) = delete;
+    ConnectionHandler &operator=(const ConnectionHandler &) = delete;
+
+    /** Processes received messages & game state changes, then flushes outgoing data.
+     *  Should be called whenever the socket becomes ready, after wakeup() and periodically (to handle timeouts).
+     */
+    void update();
+
+    int fd() const;
+    bool isRunning() const;
+
+    /// @returns true if the socket has outgoing data waiting for the socket to become writable.
+    bool wantsWrite() const;
+
+    MessageSocket &socket();
+
+    private:
+    std::unique_ptr<NFServerProtocolEntity> entity;
+    int sockfd;
+    TimePoint lastUpdate;
+};
@@ -3,48 +3,171 @@
 #include <engine/map.h>
 #include <engine/game.h>
 #include <network/protocol.h>
+#include <network/message.h>
+#include <atomic>
+#include <functional>
 #include <map>
 #include <set>
 #include <mutex>
 #include <memory>
 #include <random>
 
-/// This class is thread-safe
+/** Called when something a player is waiting for happens in their game 
+ *  (the game becomes ready or another player's moves are published).
+ *  Invoked while holding the game mutex, so it should only schedule work and must not call back into GameManager.
+ */
+typedef std::function<void()> GameListener;
+
+/** Moves played in a game, along with the GameIncrementalSync messages which broadcast them.
+ *  Each batch of moves is encoded only once, and the resulting frame is shared by 
+ *  every connection which needs to receive it.
+ * 
+ *  This class is NOT thread-safe, it should only be accessed while holding the game mutex.
+ */
+class MoveJournal {
+    public:
+
+    struct Batch {
+        /// Username of the player who made the moves, empty for moves generated by the server.
+        std::string author;
+        SharedFrame frame;
+    };
+
+    /// Records the moves and notifies all listeners except the author's.
+    void publish(const std::string &author, const std::vector<Move> &moves);
+
+    void subscribe(const std::string &username, GameListener listener);
+    void unsubscribe(const std::string &username);
+    void notifyAll();
+
+    const std::vector<Move> &moves() const;
+    const std::vector<Batch> &batches() const;
+
+    private:
+    std::vector<Move> _moves;
+    std::vector<Batch> _batches;
+    std::map<std::string, GameListener> listeners;
+};
+
+/** Lazily encoded GameFullSync message for the current version of a game, 
+ *  reused by every connection which needs a full sync until the game changes.
+ * 
+ *  This class is NOT thread-safe, it should only be accessed while holding the game mutex.
+ */
+class SnapshotCache {
+    public:
+
+    const SharedFrame &get(const Game &game);
+
+    private:
+    SharedFrame snapshot;
+    uint64_t snapshotVersion = 0;
+};
+
+/// State of a single game, shared by GameManager and all GameHandles referring to it.
+struct GameEntry {
+    GameEntry(GameID id, const Map &map) : id(id), map(&map) {}
+
+    const GameID id;
+    const Map *const map;
+    std::atomic<bool> ready = false;
+
+    // everything below is guarded by mutex
+    std::mutex mutex;
+    /// Set once the last player leaves and the game is removed from GameManager, afterwards nobody can join it
+    bool removed = false;
+    std::vector<std::string> players;
+    std::unique_ptr<Game> game;
+    MoveJournal journal;
+    SnapshotCache snapshots;
+};
+
+/** Reference to a game obtained from GameManager with a single lookup.
+ *  The game stays alive for as long as any handle refers to it, even after 
+ *  GameManager has removed it (in which case no further moves will be published).
+ * 
+ *  Thread safety: the handle itself may be copied freely, but the returned game, 
+ *  journal & snapshot cache must only be accessed while holding mutex().
+ */
+class GameHandle {
+    public:
+
+    GameHandle() = default;
+
+    explicit operator bool() const;
+    GameID id() const;
+    bool isReady() const;
+
+    std::mutex &mutex() const;
+    /// Only available once the game is ready.
+    Game &game() const;
+    MoveJournal &journal() const;
+    SnapshotCache &snapshots() const;
+    /// Usernames of players currently in the game
+    const std::vector<std::string> &players() const;
+
+    private:
+    friend class GameManager;
+    explicit GameHandle(std::shared_ptr<GameEntry> entry);
+
+    std::shared_ptr<GameEntry> entry;
+};
+
+/** This class is thread-safe
+ *  
+ *  Games are stored in a sharded slot map, so looking up a game only locks the shard containing it,
+ *  and once a connection holds a GameHandle, in-game traffic doesn't touch GameManager at all.
+ *  Game IDs contain a generation counter, so IDs of removed games are never resolved to a different game.
+ *  Players' games are sharded by username in the same way. Joining and leaving a known game only locks
+ *  that game and the shards involved, only matchmaking (joinAnyGame) goes through a lock shared by everyone.
+ * 
+ *  Lock order: game mutex -> slot shard mutex / player shard mutex, matchmaking mutex -> slot shard mutex
+ *  (the matchmaking mutex and game mutexes are never held at the same time).
+ */
 class GameManager {
     public:
 
-    GameJoinError hostNewGame(const std::string &username, const Map &map, GameID &outGameID);
-    GameJoinError joinGame(const std::string &username, GameID gameID);
-    GameJoinError joinAnyGame(const std::string &username, GameID &outGameID);
+    /// The listener is invoked for the joined game until the player leaves it (see GameListener).
+    GameJoinError hostNewGame(const std::string &username, const Map &map, GameHandle &outGame, GameListener listener = {});
+    GameJoinError joinGame(const std::string &username, GameID gameID, GameHandle &outGame, GameListener listener = {});
+    GameJoinError joinAnyGame(const std::string &username, GameHandle &outGame, GameListener listener = {});
     void leaveGame(const std::string &username);
     GameID findGameByPlayer(const std::string &username);
-    bool isGameReady(GameID id);
-    std::mutex &getGameMutex(GameID id);
-    std::vector<Move> &getMoveList(GameID id);
 
-    /** Note: the returned game object is NOT thread safe
-     *  To ensure thread safety you need to lock the mutex obtained 
-     *  from getGameMutex() before doing anything with returned game object
-     */
-    Game &getGame(GameID id);
+    /// @returns handle to the game or an empty handle if there is no such game (anymore)
+    GameHandle getGame(GameID id);
 
     private:
-    /// This method is NOT thread-safe
-    GameID initNewGame(const Map &map);
+    static constexpr unsigned shardCount = 16;
 
-    std::recursive_mutex mutex;
-    std::default_random_engine rng;
-    GameID nextGameID = 1;
-    std::map<std::string, GameID> playerGames;
-
-    struct Entry {
-        const Map *map;
-        std::unique_ptr<Game> game;
-        std::mutex gameMutex;
-        std::vector<std::string> players;
-        std::vector<Move> moveList;
-        bool ready = false;
+    struct Slot {
+        uint32_t generation = 1;
+        std::shared_ptr<GameEntry> entry;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+    };
+    struct PlayerShard {
+        std::mutex mutex;
+        std::map<std::string, GameID> playerGames;
     };
-    std::map<GameID, Entry> games;
+
+    GameHandle initNewGame(const Map &map);
+    /// Requires the game mutex to be held
+    void removeGame(GameID id);
+    /// Adds the player to the game unless it has already started or been removed
+    GameJoinError enterGame(const std::string &username, GameHandle game, GameListener listener);
+    /// Removes a game which has started (or is gone) from matchmaking
+    void stopMatchmaking(GameID id);
+    PlayerShard &playerShard(const std::string &username);
+
+    Shard shards[shardCount];
+    std::atomic<unsigned> nextShard = 0;
+    PlayerShard playerShards[shardCount];
+
+    std::mutex matchmakingMutex;
+    std::default_random_engine rng;
     std::set<GameID> joinableGames;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+/** Minimal wrapper around a Linux io_uring instance (no dependency on liburing).
+ *  
+ *  Submission queue entries are obtained with getSqe(), filled in by the caller 
+ *  and submitted in one batch by submitAndWait(). 
+ *  This class is NOT thread-safe; each thread should have its own ring.
+ */
+class IoUring {
+    public:
+
+    /** Creates a new ring.
+     *  @param entries minimum number of submission queue entries
+     *  @throw std::system_error if io_uring is not supported or the ring can't be created
+     */
+    IoUring(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    /** @returns a zeroed submission queue entry, or nullptr if the submission queue is full 
+     *  (in which case submitAndWait(0) needs to be called first).
+     */
+    io_uring_sqe *getSqe();
+
+    /** Submits all entries obtained from getSqe() and waits until at least `waitNr` completions are available.
+     *  @returns number of submitted entries
+     *  @throw std::system_error
+     */
+    unsigned submitAndWait(unsigned waitNr);
+
+    /** Calls `handler(const io_uring_cqe &)` for every available completion and removes them from the queue.
+     *  @returns number of processed completions
+     */
+    template<typename Handler>
+    unsigned forEachCompletion(Handler &&handler) {
+        unsigned head = *cqHead, count = 0;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for(; head != tail; ++head, ++count)
+            handler(cqes[head & *cqMask]);
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /** Registers buffers for use with IORING_OP_READ_FIXED/IORING_OP_WRITE_FIXED.
+     *  @returns false if registration failed (e.g. because of RLIMIT_MEMLOCK)
+     */
+    bool registerBuffers(const iovec *buffers, unsigned count);
+
+    private:
+    int ringfd = -1;
+
+    void *sqRingPtr = nullptr, *cqRingPtr = nullptr;
+    size_t sqRingSize = 0, cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned *sqHead, *sqTail, *sqMask, *sqEntries, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe *cqes;
+
+    // number of entries handed out by getSqe(), but not yet submitted
+    unsigned sqeTail = 0, sqeHead = 0;
+};
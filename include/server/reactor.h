@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <server.h>
+
+/// Mechanism used by reactor workers to perform socket I/O
+enum class IOBackend {
+    /// readiness notifications via epoll, then recv()/send() per socket
+    EPOLL,
+    /// batched asynchronous recv/send for all connections of a worker via io_uring
+    IO_URING
+};
+
+/** Multiplexes client connections over a small, fixed set of worker threads.
+ *  
+ *  Every worker owns an epoll instance (or an io_uring instance, see IOBackend) and 
+ *  the connections assigned to it, and only wakes up when one of its sockets becomes 
+ *  ready, when the GameManager reports a change in one of their games, or on a periodic 
+ *  tick used for timeouts. A connection never migrates between workers, so connection 
+ *  state doesn't need any locking.
+ * 
+ *  This class is thread-safe.
+ */
+class Reactor {
+    public:
+
+    /** Starts the worker threads.
+     *  @param backend requested I/O backend; falls back to EPOLL if io_uring is unavailable
+     *  @param threadCount number of worker threads, 0 = one per hardware thread
+     */
+    Reactor(Server &server, IOBackend backend = IOBackend::EPOLL, int threadCount = 0);
+
+    /// Waits for worker threads to finish (see join()).
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /** Hands over an accepted socket to one of the workers.
+     *  The reactor assumes exclusive ownership of the file descriptor.
+     */
+    void addConnection(int sockfd);
+
+    /// Wakes up all workers, e.g. so that they can notice a change of server status.
+    void wakeAll();
+
+    /// Blocks until the server is shutting down and all connections have been closed.
+    void join();
+
+    int threadCount() const;
+    IOBackend backend() const;
+
+    private:
+    class Worker;
+    class EpollWorker;
+    class UringWorker;
+
+    Server &server;
+    IOBackend _backend;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker = 0;
+};
@@ -5,6 +5,7 @@
 
 #include <usermanager.h>
 #include <gamemanager.h>
+#include <botmanager.h>
 
 enum class ServerStatus {
     RUNNING,
@@ -20,6 +21,7 @@ class Server {
 
     UserManager userManager;
     GameManager gameManager;
+    BotManager botManager{userManager, gameManager};
 
     ServerStatus status() const;
     
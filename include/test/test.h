@@ -0,0 +1,20 @@
+#pragma once
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/// Thrown by check() when a test fails, caught by main() which reports the failure.
+class TestFailure : public std::runtime_error {
+    public:
+    using std::runtime_error::runtime_error;
+};
+
+/// Fails the current test with given message unless `condition` holds.
+inline void check(bool condition, const std::string &message) {
+    if(!condition)
+        throw TestFailure(message);
+}
+
+// test suites, see main.cpp
+void testMoveValidation();
@@ -0,0 +1,31 @@
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <benchmark.h>
+#include <engine/content.h>
+
+int main(int argc, char **argv) {
+
+    initGameContent();
+
+    const std::vector<std::pair<const char *, std::function<void()>>> suites = {
+        {"serde", benchmarkSerde},
+        {"scheduler", benchmarkScheduler},
+        {"pathfinding", benchmarkPathfinding},
+        {"movegen", benchmarkMoveGeneration}
+    };
+
+    // with no arguments run everything, otherwise only the named suites
+    for(const auto &[name, run] : suites) {
+        bool selected = argc <= 1;
+        for(int i=1; i<argc; ++i)
+            selected |= strcmp(argv[i], name) == 0;
+        if(selected) {
+            std::cout << "== " << name << " ==" << std::endl;
+            run();
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+#include <benchmark.h>
+
+#include <vector>
+
+#include <engine/game.h>
+#include <engine/map.h>
+#include <engine/movegenerator.h>
+
+// Every ply needs its own generator & move list, since generated moves refer to the generator's storage.
+struct Ply {
+    MoveGenerator generator;
+    std::vector<GeneratedMove> moves;
+};
+
+// Number of move sequences of given length (leaves of the game tree), counted with make/unmake.
+static uint64_t perft(Game &game, std::vector<Ply> &plies, int depth) {
+    Ply &ply = plies[depth];
+    ply.generator.generate(game, ply.moves);
+    if(depth == 1)
+        return ply.moves.size();
+
+    uint64_t leaves = 0;
+    for(const auto &generated : ply.moves) {
+        MoveUndo undo;
+        game.makeMove(ply.generator.toMove(game, generated), undo);
+        leaves += perft(game, plies, depth - 1);
+        game.unmakeMove(undo);
+    }
+    return leaves;
+}
+
+void benchmarkMoveGeneration() {
+
+    Game game(1, Map::registry[Map::registry.size() - 1], {"a", "b"});
+    std::vector<Ply> plies(4);
+
+    std::vector<GeneratedMove> moves;
+    MoveGenerator generator;
+    generator.generate(game, moves);
+    std::cout << "(" << moves.size() << " legal moves in the starting position)" << std::endl;
+    runBenchmark("generate moves", [&]{
+        generator.generate(game, moves);
+        doNotOptimize(moves.data());
+    });
+
+    for(int depth=1; depth<=3; ++depth) {
+        uint64_t leaves = perft(game, plies, depth);
+        std::cout << "perft(" << depth << ") = " << leaves << std::endl;
+        runBenchmark("perft(" + std::to_string(depth) + ")", [&]{
+            doNotOptimize(perft(game, plies, depth));
+        });
+    }
+}
@@ -0,0 +1,83 @@
+#include <benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <engine/game.h>
+#include <engine/map.h>
+#include <util/scheduler.h>
+
+// Large random map with lots of units, much bigger than the built-in maps.
+static Game makeBigGame(glm::ivec2 size, int unitsPerPlayer, int movementPoints) {
+    std::mt19937 rng(42);
+    const auto &terrainTypes = TerrainType::registry;
+
+    Map map("benchmark", size, 2, &terrainTypes.getDefault());
+    for(auto &tile : map.terrain)
+        // mostly cheap terrain, so that ranges are large
+        tile = &terrainTypes[rng() % 4 == 0 ? rng() % terrainTypes.size() : 0];
+
+    Field<uint8_t> taken(size, 0);
+    for(int player = 0; player < 2; ++player)
+        for(int i=0; i<unitsPerPlayer; ++i) {
+            Unit unit;
+            unit.type = &UnitType::registry.getDefault();
+            unit.player = player;
+            unit.health = unit.type->maxHealth;
+            unit.movementPoints = movementPoints;
+            do unit.position = glm::ivec2(rng() % size.x, rng() % size.y);
+            while(taken.get(unit.position));
+            taken.set(unit.position, 1);
+            map.startingUnits[player].push_back(unit);
+        }
+    return Game(1, map, {"a", "b"});
+}
+
+void benchmarkPathfinding() {
+
+    Game game = makeBigGame({128, 128}, 256, 600);
+    std::vector<UnitHandle> units;
+    for(UnitHandle unit=0; unit<game.unitPool.capacity(); ++unit)
+        if(game.unitPool.contains(unit) && game.unitPool.player[unit] == 0)
+            units.push_back(unit);
+
+    PathfindingScratch scratch;
+    runBenchmark("reachable tiles, 1 unit, 128x128 map", [&]{
+        UnitHandle unit = units[0];
+        auto tiles = scratch.findReachableTiles(game.movementCosts, game.occupancy(), game.unitPool.position[unit], game.unitPool.movementPoints[unit]);
+        doNotOptimize(tiles.size());
+    });
+
+    // A* only explores towards the target, a flood fill explores the whole range
+    std::vector<glm::ivec2> path;
+    glm::ivec2 start = game.unitPool.position[units[0]], target = start;
+    for(const auto &tile : scratch.findReachableTiles(game.movementCosts, game.occupancy(), start, game.unitPool.movementPoints[units[0]]))
+        if(taxicabDistance(start, tile.position) == 8)
+            target = tile.position;
+    game.distances();
+    runBenchmark("path to a tile 8 steps away, flood fill", [&]{
+        auto tiles = scratch.findReachableTiles(game.movementCosts, game.occupancy(), start, game.unitPool.movementPoints[units[0]]);
+        tiles.path(target, path);
+        doNotOptimize(path.data());
+    });
+    runBenchmark("path to a tile 8 steps away, A*", [&]{
+        scratch.findPath(game.movementCosts, game.occupancy(), game.distances(), start, target, game.unitPool.movementPoints[units[0]], path);
+        doNotOptimize(path.data());
+    });
+
+    // the batch API doesn't populate the cache, so every iteration searches all units again
+    runBenchmark("reachable tiles, 256 units, sequential", [&]{
+        for(UnitHandle unit : units) {
+            auto tiles = scratch.findReachableTiles(game.movementCosts, game.occupancy(), game.unitPool.position[unit], game.unitPool.movementPoints[unit]);
+            doNotOptimize(tiles.size());
+        }
+    });
+
+    Scheduler scheduler;
+    ReachabilityBatch batch;
+    std::cout << "(" << scheduler.threadCount() << " worker threads)" << std::endl;
+    runBenchmark("reachable tiles, 256 units, parallel batch", [&]{
+        game.findReachableTiles(0, batch, scheduler);
+        doNotOptimize(batch.size());
+    });
+}
@@ -0,0 +1,92 @@
+#include <benchmark.h>
+
+#include <cmath>
+#include <future>
+#include <numeric>
+#include <vector>
+
+#include <util/scheduler.h>
+
+// Work done by a single small task, roughly what evaluating one tile or one move costs.
+static double smallTask(size_t seed) {
+    double x = static_cast<double>(seed);
+    for(int i=0; i<64; ++i)
+        x = std::sqrt(x + i);
+    return x;
+}
+
+void benchmarkScheduler() {
+
+    Scheduler scheduler;
+    const int threadCount = scheduler.threadCount();
+    std::cout << "(" << threadCount << " worker threads)" << std::endl;
+
+    constexpr size_t taskCount = 1024;
+    std::vector<double> results(taskCount);
+
+    runBenchmark("spawn 1024 small tasks, std::async", [&]{
+        std::vector<std::future<void>> futures;
+        futures.reserve(taskCount);
+        for(size_t i=0; i<taskCount; ++i)
+            futures.push_back(std::async(std::launch::async, [&results, i]{ results[i] = smallTask(i); }));
+        for(auto &future : futures)
+            future.get();
+        doNotOptimize(results.data());
+    });
+
+    runBenchmark("spawn 1024 small tasks, TaskGroup", [&]{
+        TaskGroup group(scheduler);
+        for(size_t i=0; i<taskCount; ++i)
+            group.run([&results, i]{ results[i] = smallTask(i); });
+        group.wait();
+        doNotOptimize(results.data());
+    });
+
+    // the usual hand-written alternative to parallelFor: one std::async per thread
+    constexpr size_t elementCount = 1 << 16;
+    std::vector<double> elements(elementCount);
+
+    runBenchmark("64Ki elements, one std::async per thread", [&]{
+        std::vector<std::future<void>> futures;
+        size_t chunkSize = (elementCount + threadCount - 1) / threadCount;
+        for(size_t begin = 0; begin < elementCount; begin += chunkSize) {
+            size_t end = std::min(elementCount, begin + chunkSize);
+            futures.push_back(std::async(std::launch::async, [&elements, begin, end]{
+                for(size_t i=begin; i<end; ++i)
+                    elements[i] = smallTask(i);
+            }));
+        }
+        for(auto &future : futures)
+            future.get();
+        doNotOptimize(elements.data());
+    });
+
+    runBenchmark("64Ki elements, parallelFor", [&]{
+        parallelFor(scheduler, 0, elementCount, [&elements](size_t i){ elements[i] = smallTask(i); }, 256);
+        doNotOptimize(elements.data());
+    });
+
+    runBenchmark("64Ki elements, sequential", [&]{
+        for(size_t i=0; i<elementCount; ++i)
+            elements[i] = smallTask(i);
+        doNotOptimize(elements.data());
+    });
+
+    // recursively split work, where LIFO execution & stealing matter most
+    std::function<void(TaskGroup &, size_t, size_t)> split = [&](TaskGroup &group, size_t begin, size_t end) {
+        if(end - begin <= 64) {
+            for(size_t i=begin; i<end; ++i)
+                elements[i] = smallTask(i);
+            return;
+        }
+        size_t middle = begin + (end - begin) / 2;
+        group.run([&split, &group, middle, end]{ split(group, middle, end); });
+        split(group, begin, middle);
+    };
+    runBenchmark("64Ki elements, recursive split, TaskGroup", [&]{
+        TaskGroup group(scheduler);
+        split(group, 0, elementCount);
+        group.wait();
+        doNotOptimize(elements.data());
+    });
+}
@@ -0,0 +1,102 @@
+#include <benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <network/rxbuffer.h>
+#include <network/txbuffer.h>
+#include <engine/field.h>
+#include <engine/move.h>
+
+// Element-by-element serialization, equivalent to what the generic templates did before
+// bulk (de)serialization was introduced. Kept here as a baseline for comparison.
+
+static void writeElementwise(TxBuffer &tx, const std::vector<int32_t> &values) {
+    tx << static_cast<uint32_t>(values.size());
+    for(auto value : values)
+        tx << value;
+}
+
+static void readElementwise(RxBuffer &rx, std::vector<int32_t> &result) {
+    auto size = rx.read<uint32_t>();
+    result.clear();
+    result.reserve(size);
+    for(uint32_t i=0; i<size; ++i)
+        result.push_back(rx.read<int32_t>());
+}
+
+static void writeElementwise(TxBuffer &tx, const std::string &value) {
+    tx << static_cast<uint32_t>(value.size());
+    for(char character : value)
+        tx << static_cast<uint8_t>(character);
+}
+
+static void readElementwise(RxBuffer &rx, std::string &result) {
+    auto size = rx.read<uint32_t>();
+    result.clear();
+    result.reserve(size);
+    for(uint32_t i=0; i<size; ++i)
+        result += static_cast<char>(rx.read<uint8_t>());
+}
+
+template<typename T>
+static void benchmarkRoundtrip(const std::string &name, const T &value, size_t payloadBytes) {
+
+    TxBuffer tx;
+    tx << value;
+    RxBuffer rx(tx.ptr(), tx.size());
+    T result;
+
+    runBenchmark(name + " write (elementwise)", [&]{
+        tx.truncate(0);
+        writeElementwise(tx, value);
+        doNotOptimize(tx.ptr());
+    }, payloadBytes);
+    runBenchmark(name + " write (bulk)", [&]{
+        tx.truncate(0);
+        tx << value;
+        doNotOptimize(tx.ptr());
+    }, payloadBytes);
+    runBenchmark(name + " read (elementwise)", [&]{
+        rx.setPosition(0);
+        readElementwise(rx, result);
+        doNotOptimize(result);
+    }, payloadBytes);
+    runBenchmark(name + " read (bulk)", [&]{
+        rx.setPosition(0);
+        rx >> result;
+        doNotOptimize(result);
+    }, payloadBytes);
+}
+
+void benchmarkSerde() {
+
+    std::vector<int32_t> moveArgs = {3,4, 3,5, 4,5, 5,5, 5,6, 6,6, 6,7};
+    benchmarkRoundtrip("Move::args (14 x int32)", moveArgs, moveArgs.size()*sizeof(int32_t));
+
+    std::vector<int32_t> largeVector(64*1024);
+    for(size_t i=0; i<largeVector.size(); ++i)
+        largeVector[i] = static_cast<int32_t>(i*2654435761u);
+    benchmarkRoundtrip("std::vector<int32_t> (64Ki elements)", largeVector, largeVector.size()*sizeof(int32_t));
+
+    std::string username = "a_rather_long_username_0123456789";
+    benchmarkRoundtrip("username (33 chars)", username, username.size());
+
+    Field<int32_t> grid(glm::ivec2(256, 256));
+    for(int y=0; y<256; ++y)
+        for(int x=0; x<256; ++x)
+            grid.set(glm::ivec2(x,y), x*y);
+    TxBuffer tx;
+    runBenchmark("Field<int32_t> 256x256 write", [&]{
+        tx.truncate(0);
+        tx << grid;
+        doNotOptimize(tx.ptr());
+    }, 256*256*sizeof(int32_t));
+    RxBuffer rx(tx.ptr(), tx.size());
+    Field<int32_t> result;
+    runBenchmark("Field<int32_t> 256x256 read", [&]{
+        rx.setPosition(0);
+        rx >> result;
+        doNotOptimize(result);
+    }, 256*256*sizeof(int32_t));
+}
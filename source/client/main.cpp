@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <inttypes.h>
 
 #include <glm/glm.hpp>
@@ -47,7 +48,9 @@ class NFClientProtocolEntity : public NFProtocolEntity {
     std::vector<AtlasArea> unitSprites, terrainSprites;
     AtlasArea victoryMsg, defeatMsg;
     
-    std::map<glm::ivec2, glm::ivec2, IVec2Comparator> selectedUnitMovementRange;
+    // points into memory owned by the game, looked up again every frame (the game caches it)
+    ReachableTiles selectedUnitMovementRange;
+    std::vector<glm::ivec2> hoveredPath;
     int playerIndex;
     std::vector<Move> savedMoves;
 
@@ -206,7 +209,7 @@ class NFClientProtocolEntity : public NFProtocolEntity {
                 ImGui::Begin("Info");
                 ImGui::Text("Waiting for other players to join.");
                 if(gameID)
-                    ImGui::Text("Game ID = %d", (int)gameID);
+                    ImGui::Text("Game ID = %" PRId64, gameID);
                 if(ImGui::Button("Leave game")) {
                     sendLeaveGameRequest({});
                     guiFsm = GAME_LOBBY;
@@ -222,31 +225,27 @@ class NFClientProtocolEntity : public NFProtocolEntity {
                 auto selectedUnit = game->unitAt(selectedTile);
                 auto hoveredUnit = game->unitAt(gridMousePos);
 
-                if(selectedUnit != nullptr) {
+                if(selectedUnit) {
                     selectedUnitMovementRange = game->findReachableTiles(*selectedUnit);
                 } else
-                    selectedUnitMovementRange.clear();
+                    selectedUnitMovementRange = {};
 
                 if(!io.WantCaptureMouse) {
                     if(io.MouseClicked[0]) {
 
                         if(selectedTile == gridMousePos) //selecting same thing twice = deselection
                             selectedTile = NO_TILE_SELECTED;
-                        else if(selectedUnit == nullptr || selectedUnit->player != playerIndex || !myTurn) { 
+                        else if(!selectedUnit || selectedUnit->player != playerIndex || !myTurn) { 
                             selectedTile = gridMousePos;
                         } else { //friendly unit is selected and we can make a move
-                            if(selectedUnitMovementRange.find(gridMousePos) != selectedUnitMovementRange.end()) {
+                            if(game->findPath(*selectedUnit, gridMousePos, hoveredPath)) {
                                 //we clicked a location, which can be moved to!
-                                std::vector<glm::ivec2> path = {gridMousePos};
-                                while(path.back() != selectedUnit->position)
-                                    path.push_back(selectedUnitMovementRange[path.back()]);
-                                std::reverse(path.begin(), path.end());
-                                makeMove(Move::moveUnit(path));
+                                makeMove(Move::moveUnit(hoveredPath));
 
-                            } else if (selectedUnit->actionPoints > 0 && hoveredUnit != nullptr && hoveredUnit->player != playerIndex && areTilesAdjacent(selectedTile, gridMousePos)) {
+                            } else if (selectedUnit->actionPoints > 0 && hoveredUnit && hoveredUnit->player != playerIndex && areTilesAdjacent(selectedTile, gridMousePos)) {
                                 //we clicked on an enemy unit in attack range
                                 makeMove(Move::attackUnit(*selectedUnit, *hoveredUnit));
-                                if(selectedUnit->actionPoints <= 0)
+                                if(game->unitPool.actionPoints[game->unitHandleAt(selectedTile)] <= 0)
                                     selectedTile = NO_TILE_SELECTED;
                             } else {
                                 selectedTile = gridMousePos;
@@ -267,9 +266,9 @@ class NFClientProtocolEntity : public NFProtocolEntity {
                     }
                 ImGui::End();
 
-                if(selectedUnit != nullptr)
+                if(selectedUnit)
                     showUnitInfo("Selected unit", *selectedUnit);
-                if(hoveredUnit != nullptr && hoveredUnit != selectedUnit)
+                if(hoveredUnit && gridMousePos != selectedTile)
                     showUnitInfo("Hovered unit", *hoveredUnit);
 
                 if(!savedMoves.empty()) {
@@ -288,26 +287,32 @@ class NFClientProtocolEntity : public NFProtocolEntity {
 
         renderer.clear();
         
-        for(int x=0; x<game->terrain.size().x; ++x)
-            for(int y=0; y<game->terrain.size().y; ++y) {
+        const auto &units = game->unitPool;
+        const auto &unitStats = UnitType::registry.stats();
+        for(int y=0; y<game->terrain.size().y; ++y) {
+            auto terrainRow = game->terrain.row(y);
+            auto unitRow = game->units.row(y);
+            for(int x=0; x<terrainRow.size(); ++x) {
                 glm::ivec2 pos = glm::ivec2(x,y);
 
-                auto terrainSprite = terrainSprites[game->terrain.get(pos)->numericID];
+                auto terrainSprite = terrainSprites[terrainRow[x]];
                 renderer.drawImage(terrainSprite, pos, glm::vec2(0.5f));
 
-                auto unit = game->unitAt(pos);
-                if(unit != nullptr) {
+                UnitHandle unit = unitRow[x];
+                if(unit != NO_UNIT) {
+                    UnitTypeID unitType = units.type[unit];
+                    int health = units.health[unit], maxHealth = unitStats.maxHealth[unitType];
 
-                    renderer.mulColor(unit->player == playerIndex ? glm::vec4(0,1,0,0.25) : glm::vec4(1,0,0,0.25));
+                    renderer.mulColor(units.player[unit] == playerIndex ? glm::vec4(0,1,0,0.25) : glm::vec4(1,0,0,0.25));
                     renderer.drawRectangle(pos, glm::vec2(0.5f));
                     renderer.mulColor();
 
-                    auto unitSprite = unitSprites[unit->type->numericID];
+                    auto unitSprite = unitSprites[unitType];
                     renderer.drawImage(unitSprite, pos, glm::vec2(0.5f));
 
-                    if(unit->health < unit->type->maxHealth) {
-                        glm::vec2 hpBarCenter = glm::vec2(0,-0.45f) + glm::vec2(unit->position), hpBarRadii = glm::vec2(0.4f, 0.025f);
-                        float relativeHealthLeft = unit->health / (float) unit->type->maxHealth;
+                    if(health < maxHealth) {
+                        glm::vec2 hpBarCenter = glm::vec2(0,-0.45f) + glm::vec2(pos), hpBarRadii = glm::vec2(0.4f, 0.025f);
+                        float relativeHealthLeft = health / (float) maxHealth;
 
                         renderer.mulColor({0,0,0,1});
                         renderer.drawRectangle(hpBarCenter, hpBarRadii);
@@ -321,10 +326,30 @@ class NFClientProtocolEntity : public NFProtocolEntity {
                     }
                 }
             }
+        }
+
+        // danger overlay: tiles where enemies could hit the selected unit during their next turn
+        auto selectedUnit = game->unitAt(selectedTile);
+        if(selectedUnit && selectedUnit->player == playerIndex) {
+            const auto &threats = game->threats();
+            for(int y=0; y<game->terrain.size().y; ++y)
+                for(int x=0; x<game->terrain.size().x; ++x) {
+                    int damage = 0;
+                    for(int player=0; player<game->playerCount(); ++player)
+                        if(player != playerIndex)
+                            damage += threats.damage(player, *selectedUnit->type).get({x,y});
+                    if(damage > 0) {
+                        float danger = std::min(1.0f, static_cast<float>(damage) / selectedUnit->health);
+                        renderer.mulColor({1,0,0,0.15f + 0.35f*danger});
+                        renderer.drawRectangle(glm::ivec2(x,y), glm::vec2(0.5f));
+                        renderer.mulColor();
+                    }
+                }
+        }
 
         renderer.mulColor(glm::vec4(1,1,0,1) * glm::vec4(sin(glfwGetTime()*8)*0.3300 + 0.3301));
-        for(auto [succ,pred] : selectedUnitMovementRange)
-            renderer.drawRectangle(succ, glm::vec2(0.5f));
+        for(const auto &tile : selectedUnitMovementRange)
+            renderer.drawRectangle(tile.position, glm::vec2(0.5f));
         renderer.mulColor();
 
         if(game->terrain.inBounds(gridMousePos)) {
@@ -333,11 +358,9 @@ class NFClientProtocolEntity : public NFProtocolEntity {
             renderer.mulColor();
         }
 
-        if(selectedUnitMovementRange.find(gridMousePos) != selectedUnitMovementRange.end()) {
-            auto p1 = gridMousePos;
-            for(auto p2 = selectedUnitMovementRange[p1]; p1 != p2; p1 = p2, p2 = selectedUnitMovementRange[p2])
-                renderer.drawLine(p1, p2, 0.1);
-        }
+        if(selectedUnit && game->findPath(*selectedUnit, gridMousePos, hoveredPath))
+            for(size_t i=1; i<hoveredPath.size(); ++i)
+                renderer.drawLine(hoveredPath[i-1], hoveredPath[i], 0.1);
 
         glm::vec2 msgCenter = glm::vec2(game->terrain.size())/glm::vec2(2);
         glm::vec2 msgRadii = {msgCenter.x, msgCenter.x*9/16};
@@ -353,6 +376,7 @@ class NFClientProtocolEntity : public NFProtocolEntity {
 
     void onFullSync(const Game &gameState) override {
         std::cerr << "Received full sync from server!";
+        selectedUnitMovementRange = {};
         game = std::make_unique<Game>(gameState);
         playerIndex = game->getPlayerIndex(usernameStr);
         projMatrix[0][0] = 1.8f / game->terrain.size().x;
@@ -366,12 +390,11 @@ class NFClientProtocolEntity : public NFProtocolEntity {
         if(guiFsm != INGAME)
             return;
 
-        for(auto move : sync.moveList)
-            try {
-                game->makeMove(move);
-            } catch (InvalidMoveError e) {
-                throw ProtocolError(std::string("Invalid move in received IncrementalSync: ") + std::string(e.what()));
-            }
+        for(const auto &move : sync.moveList) {
+            MoveStatus status = game->tryMakeMove(move);
+            if(status != MoveStatus::OK)
+                throw ProtocolError(std::string("Invalid move in received IncrementalSync: ") + moveStatusMessage(status));
+        }
     }
 
     void onHostGameAck(const HostGameAck &ack) {
@@ -540,5 +563,9 @@ int createClientSocket(const std::string &serverAddress, uint16_t serverPort) {
         return -1;
     }
 
+    // moves are small and should reach the server immediately
+    int noDelay = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof noDelay);
+
     return sockfd;
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <engine/distanceoracle.h>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+#include <engine/bitboard.h>
+#include <engine/pathfinding.h>
+
+// more than any path on a map can cost, but small enough to never overflow during the search
+static constexpr int unlimitedMovementPoints = INT_MAX / 2;
+
+// terrain-only costs from `source` to every tile, in row-major order
+static void singleSource(
+    PathfindingScratch &scratch,
+    const Field<uint16_t> &movementCosts,
+    const Bitboard &noUnits,
+    const glm::ivec2 &source,
+    std::vector<int> &outCosts
+) {
+    auto tiles = scratch.findReachableTiles(movementCosts, noUnits, source, unlimitedMovementPoints);
+    // nothing is blocked, so every tile is reachable and the (row-major) result lines up with tile indices
+    assert(tiles.size() == outCosts.size());
+    for(size_t i=0; i<tiles.size(); ++i)
+        outCosts[i] = unlimitedMovementPoints - tiles.begin()[i].movementPointsLeft;
+}
+
+DistanceOracle::DistanceOracle(const Field<uint16_t> &movementCosts) :
+    _size(movementCosts.size()),
+    tileCount(static_cast<size_t>(_size.x) * _size.y)
+{
+    if(tileCount == 0)
+        return;
+
+    minStepCost = 2 * *std::min_element(movementCosts.begin(), movementCosts.end());
+
+    PathfindingScratch scratch;
+    Bitboard noUnits(_size);
+    std::vector<int> costs(tileCount);
+
+    if(tileCount <= maxAllPairsTiles) {
+        allPairs.resize(tileCount * tileCount);
+        bool fits = true;
+        for(size_t from=0; from<tileCount && fits; ++from) {
+            singleSource(scratch, movementCosts, noUnits, noUnits.position(from), costs);
+            for(size_t to=0; to<tileCount; ++to) {
+                if(costs[to] > UINT16_MAX) {
+                    fits = false;
+                    break;
+                }
+                allPairs[from * tileCount + to] = static_cast<uint16_t>(costs[to]);
+            }
+        }
+        if(fits)
+            return;
+        // very expensive terrain, fall back to landmarks
+        allPairs.clear();
+        allPairs.shrink_to_fit();
+    }
+
+    // farthest point selection: every next landmark is the tile farthest away from all previous ones
+    int count = static_cast<int>(std::min<size_t>(landmarkCount, tileCount));
+    landmarkDistances.resize(count * tileCount);
+    std::vector<int> distanceToNearestLandmark(tileCount, INT_MAX);
+    size_t landmark = 0;
+    for(int l=0; l<count; ++l) {
+        singleSource(scratch, movementCosts, noUnits, noUnits.position(landmark), costs);
+        std::copy(costs.begin(), costs.end(), landmarkDistances.begin() + l * tileCount);
+        for(size_t tile=0; tile<tileCount; ++tile)
+            distanceToNearestLandmark[tile] = std::min(distanceToNearestLandmark[tile], costs[tile]);
+        landmark = std::max_element(distanceToNearestLandmark.begin(), distanceToNearestLandmark.end()) - distanceToNearestLandmark.begin();
+    }
+}
+
+glm::ivec2 DistanceOracle::size() const {
+    return _size;
+}
+
+bool DistanceOracle::isExact() const {
+    return !allPairs.empty();
+}
+
+size_t DistanceOracle::index(const glm::ivec2 &position) const {
+    assert(static_cast<unsigned>(position.x) < static_cast<unsigned>(_size.x));
+    assert(static_cast<unsigned>(position.y) < static_cast<unsigned>(_size.y));
+    return static_cast<size_t>(position.y) * _size.x + position.x;
+}
+
+int DistanceOracle::lowerBound(const glm::ivec2 &from, const glm::ivec2 &to) const {
+    size_t a = index(from), b = index(to);
+    if(isExact())
+        return allPairs[a * tileCount + b];
+
+    int result = minStepCost * (std::abs(from.x - to.x) + std::abs(from.y - to.y));
+    for(size_t l=0; l<landmarkDistances.size(); l += tileCount)
+        result = std::max(result, std::abs(landmarkDistances[l + a] - landmarkDistances[l + b]));
+    return result;
+}
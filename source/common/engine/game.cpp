@@ -2,45 +2,57 @@
 
 #include <cassert>
 #include <numeric>
-#include <queue>
 
 Game::Game() {}
 
 Game::Game(GameID id, const Map &map, const std::vector<std::string> &playerUsernames) :
-    terrain(map.terrain),
-    units(terrain.size(), nullptr),
-    playerUnitPositions(map.playerCount()),
+    terrain(terrainIDField(map.terrain)),
+    movementCosts(movementCostField(terrain)),
+    units(terrain.size(), NO_UNIT),
     _id(id),
-    playerUsernames(playerUsernames)
+    allUnits(terrain.size()),
+    playerUnits(map.playerCount(), allUnits),
+    playerUsernames(playerUsernames),
+    distanceOracle(map.distances),
+    threatMap(map.playerCount(), terrain.size())
 {
     assert(map.playerCount() == playerUsernames.size());
     //spawn starting units
     for(int player = 0; player < map.playerCount(); ++player)
         for(const auto &unit : map.startingUnits[player])
-            spawn(std::make_shared<Unit>(unit));
+            spawn(unit);
 }
 
 int Game::playerCount() const {
-    return static_cast<int>(playerUnitPositions.size());
+    return static_cast<int>(playerUnits.size());
 }
 
 const std::string &Game::currentPlayer() const {
     return playerUsernames[_currentPlayer];
 }
+int Game::currentPlayerIndex() const {
+    return _currentPlayer;
+}
 GameID Game::id() const {
     return _id;
 }
+uint64_t Game::version() const {
+    return _version;
+}
 
-std::shared_ptr<const Unit> Game::unitAt(const glm::ivec2 &position) const {
-    return units.getOr(position, {});
+std::optional<Unit> Game::unitAt(const glm::ivec2 &position) const {
+    UnitHandle handle = unitHandleAt(position);
+    if(handle == NO_UNIT)
+        return std::nullopt;
+    return unitPool.get(handle);
 }
 
-std::shared_ptr<Unit> Game::unitAt(const glm::ivec2 &position) {
-    return units.getOr(position, {});
+UnitHandle Game::unitHandleAt(const glm::ivec2 &position) const {
+    return units.inBounds(position) ? units.get(position) : NO_UNIT;
 }
 
-bool Game::isTileOccupied(const glm::ivec2 &position) {
-    return unitAt(position) != nullptr;
+bool Game::isTileOccupied(const glm::ivec2 &position) const {
+    return allUnits.testOr(position, false);
 }
 
 int Game::getPlayerIndex(const std::string &username) {
@@ -50,189 +62,548 @@ int Game::getPlayerIndex(const std::string &username) {
     return -1;
 }
 
-void Game::spawn(std::shared_ptr<Unit> unit) {
-    assert(!unitAt(unit->position));
-    assert(unit->player >= 0 && unit->player < playerCount());
-    playerUnitPositions[unit->player].insert(unit->position);
-    units.set(unit->position, unit);
+void Game::spawn(const Unit &unit) {
+    assert(!isTileOccupied(unit.position));
+    assert(unit.player >= 0 && unit.player < playerCount());
+    ++_version;
+    units.set(unit.position, unitPool.add(unit));
+    setOccupied(unit.position, unit.player);
 }
 
 void Game::endTurn() {
-    for(auto &unitPos : playerUnitPositions[_currentPlayer])
-        unitAt(unitPos)->update(*this);
+    ++_version;
+    // replenish movement & action points of the current player's units
+    const auto &stats = UnitType::registry.stats();
+    for(size_t unit=0; unit<unitPool.capacity(); ++unit) {
+        UnitTypeID type = unitPool.type[unit];
+        if(type != NO_UNIT_TYPE && unitPool.player[unit] == _currentPlayer) {
+            unitPool.movementPoints[unit] = stats.movementPointsPerTurn[type];
+            unitPool.actionPoints[unit] = stats.actionPointsPerTurn[type];
+        }
+    }
 
     int maxRetries = playerCount();
     do _currentPlayer = (_currentPlayer + 1) % playerCount();
-    while(playerUnitPositions[_currentPlayer].empty() && maxRetries--);
+    while(playerUnits[_currentPlayer].none() && maxRetries--);
 }
 
 void Game::forceSurrender(const std::string &username) {
     int idx = getPlayerIndex(username);
     assert(idx != -1);
-
-    for(auto unitPos : playerUnitPositions[idx])
-        units.set(unitPos, {});
-    playerUnitPositions[idx].clear();
+    ++_version;
+
+    playerUnits[idx].forEach([this](glm::ivec2 unitPos){
+        unitPool.remove(units.get(unitPos));
+        units.set(unitPos, NO_UNIT);
+        reachabilityCache.invalidate(unitPos);
+        threatMap.invalidate(unitPos);
+    });
+    allUnits.subtract(playerUnits[idx]);
+    playerUnits[idx].clear();
 }
 
 // player wins if they still have units remaining and all other players have lost
 bool Game::didPlayerWin(const std::string &username) {
     int idx = getPlayerIndex(username);
     assert(idx != -1);
-    if(playerUnitPositions[idx].empty())
-        return false;
-    for(int j=0; j<playerCount(); ++j)
-        if(j != idx && !playerUnitPositions[j].empty())
-            return false;
-    return true;
+    // all remaining units belong to the player
+    int remaining = unitCount(idx);
+    return remaining > 0 && remaining == allUnits.count();
 }
 bool Game::didPlayerLoose(const std::string &username) {
     int idx = getPlayerIndex(username);
     assert(idx != -1);
-    return playerUnitPositions[idx].empty(); //player looses when they have no units left
+    return playerUnits[idx].none(); //player looses when they have no units left
+}
+int Game::unitCount(int player) const {
+    return playerUnits[player].count();
 }
 
-void Game::makeMove(const Move &m) {
+const Bitboard &Game::occupancy() const {
+    return allUnits;
+}
+const Bitboard &Game::occupancy(int player) const {
+    return playerUnits[player];
+}
+
+MoveStatus Game::validateMove(const Move &m) const {
     switch(m.type) {
 
         case MoveType::MOVE_UNIT: {
             if(m.args.size() % 2 != 0)
-                throw InvalidMoveError("Malformed move description.");
-            for(int i=0; i+2<m.args.size(); i+=2)
-                moveUnitOneTile(glm::ivec2(m.args[i], m.args[i+1]), glm::ivec2(m.args[i+2], m.args[i+3]));
+                return MoveStatus::MALFORMED;
+            if(m.args.size() < 4)
+                return MoveStatus::OK;
+
+            glm::ivec2 start(m.args[0], m.args[1]);
+            if(!terrain.inBounds(start))
+                return MoveStatus::OUT_OF_BOUNDS;
+            UnitHandle unit = unitHandleAt(start);
+            if(unit == NO_UNIT)
+                return MoveStatus::NO_UNIT;
+            if(unitPool.player[unit] != _currentPlayer)
+                return MoveStatus::NOT_OWNED;
+
+            int movementPoints = unitPool.movementPoints[unit];
+            glm::ivec2 from = start;
+            for(size_t i=2; i<m.args.size(); i+=2) {
+                glm::ivec2 to(m.args[i], m.args[i+1]);
+                if(!areTilesAdjacent(from, to))
+                    return MoveStatus::DISCONTINUOUS_PATH;
+                if(movementPoints <= 0)
+                    return MoveStatus::NO_MOVEMENT_POINTS;
+                if(!terrain.inBounds(to))
+                    return MoveStatus::OUT_OF_BOUNDS;
+                // the unit leaves its starting tile, so it may pass through it again
+                if(to != start && isTileOccupied(to))
+                    return MoveStatus::DESTINATION_OCCUPIED;
+                movementPoints -= adjacentTileMovementCost(from, to);
+                from = to;
+            }
         }
-        break;
+        return MoveStatus::OK;
 
         case MoveType::ATTACK_UNIT: {
             if(m.args.size() != 4)
-                throw InvalidMoveError("Malformed move description.");
+                return MoveStatus::MALFORMED;
+
+            glm::ivec2 pAttacker(m.args[0], m.args[1]), pTarget(m.args[2], m.args[3]);
+            if(!terrain.inBounds(pAttacker) || !terrain.inBounds(pTarget))
+                return MoveStatus::OUT_OF_BOUNDS;
+            UnitHandle attacker = unitHandleAt(pAttacker), target = unitHandleAt(pTarget);
+
+            if(attacker == NO_UNIT)
+                return MoveStatus::NO_UNIT;
+            if(unitPool.player[attacker] != _currentPlayer)
+                return MoveStatus::NOT_OWNED;
+            if(target == NO_UNIT)
+                return MoveStatus::NO_TARGET;
+            if(unitPool.player[target] == _currentPlayer)
+                return MoveStatus::FRIENDLY_TARGET;
+            if(taxicabDistance(pAttacker, pTarget) > UnitType::registry.stats().attackRange[unitPool.type[attacker]])
+                return MoveStatus::OUT_OF_RANGE;
+            if(unitPool.actionPoints[attacker] <= 0)
+                return MoveStatus::NO_ACTION_POINTS;
+        }
+        return MoveStatus::OK;
+
+        case MoveType::END_TURN:
+        case MoveType::SURRENDER:
+            return MoveStatus::OK;
+
+        // only generated by the server, but games received over the network are still checked
+        case MoveType::FORCED_SURRENDER:
+            if(m.args.size() != 1 || m.args[0] < 0 || m.args[0] >= playerCount())
+                return MoveStatus::MALFORMED;
+            return MoveStatus::OK;
+
+        default:
+            return MoveStatus::NOT_IMPLEMENTED;
+    }
+}
+
+MoveStatus Game::validateMoves(const std::vector<Move> &moves, size_t *outFailedMove) const {
+    MoveStatus status = MoveStatus::OK;
+    size_t failedMove = 0;
+
+    // later moves depend on earlier ones, so anything longer than one move is checked on a copy
+    if(moves.size() == 1) {
+        status = validateMove(moves[0]);
+    } else if(moves.size() > 1) {
+        Game copy = stateCopy();
+        for(; failedMove<moves.size(); ++failedMove)
+            if((status = copy.tryMakeMove(moves[failedMove])) != MoveStatus::OK)
+                break;
+    }
+    if(status != MoveStatus::OK && outFailedMove)
+        *outFailedMove = failedMove;
+    return status;
+}
+
+MoveStatus Game::tryMakeMove(const Move &m) {
+    MoveStatus status = validateMove(m);
+    if(status == MoveStatus::OK)
+        applyMove(m, nullptr);
+    return status;
+}
+
+MoveStatus Game::tryMakeMove(const Move &m, MoveUndo &outUndo) {
+    MoveStatus status = validateMove(m);
+    if(status == MoveStatus::OK)
+        applyMove(m, &outUndo);
+    return status;
+}
+
+void Game::makeMove(const Move &m) {
+    MoveStatus status = tryMakeMove(m);
+    if(status != MoveStatus::OK)
+        throw InvalidMoveError(status);
+}
+
+void Game::makeMove(const Move &m, MoveUndo &outUndo) {
+    MoveStatus status = tryMakeMove(m, outUndo);
+    if(status != MoveStatus::OK)
+        throw InvalidMoveError(status);
+}
+
+MoveStatus Game::tryMakeMoves(const std::vector<Move> &moves, size_t *outFailedMove) {
+    // the batch's entries go on top of the undo stacks, they are only needed until it either fails or succeeds
+    size_t removedUnitsSize = removedUnits.size(), savedPointsSize = savedPoints.size();
+    batchUndo.resize(moves.size());
+    for(size_t i=0; i<moves.size(); ++i) {
+        MoveStatus status = tryMakeMove(moves[i], batchUndo[i]);
+        if(status != MoveStatus::OK) {
+            if(outFailedMove)
+                *outFailedMove = i;
+            while(i--)
+                unmakeMove(batchUndo[i]);
+            return status;
+        }
+    }
+    removedUnits.resize(removedUnitsSize);
+    savedPoints.resize(savedPointsSize);
+    return MoveStatus::OK;
+}
+
+void Game::applyMove(const Move &m, MoveUndo *outUndo) {
+    assert(validateMove(m) == MoveStatus::OK);
+    ++_version;
 
+    MoveUndo undo;
+    undo.type = m.type;
+    undo.previousPlayer = static_cast<uint8_t>(_currentPlayer);
+
+    switch(m.type) {
+
+        case MoveType::MOVE_UNIT: {
+            if(m.args.size() < 4)
+                break;
+            // only the endpoints matter, the unit doesn't stop on the tiles in between
+            glm::ivec2 from(m.args[0], m.args[1]), to = from;
+            UnitHandle unit = unitHandleAt(from);
+            undo.unit = unit;
+            undo.from = from;
+            undo.movementPoints = unitPool.movementPoints[unit];
+            int &movementPoints = unitPool.movementPoints[unit];
+            for(size_t i=2; i<m.args.size(); i+=2) {
+                glm::ivec2 next(m.args[i], m.args[i+1]);
+                movementPoints -= adjacentTileMovementCost(to, next);
+                to = next;
+            }
+            if(to == from)
+                break;
+
+            unitPool.position[unit] = to;
+            units.set(to, unit);
+            units.set(from, NO_UNIT);
+            setUnoccupied(from, _currentPlayer);
+            setOccupied(to, _currentPlayer);
+        }
+        break;
+
+        case MoveType::ATTACK_UNIT: {
             glm::ivec2 pAttacker(m.args[0], m.args[1]), pTarget(m.args[2], m.args[3]);
-            auto attacker = unitAt(pAttacker), target = unitAt(pTarget);
-
-            if(attacker == nullptr)
-                throw InvalidMoveError("No attacking unit.");
-            if(attacker->player != _currentPlayer)
-                throw InvalidMoveError("Player does not own the unit.");
-            if(target == nullptr)
-                throw InvalidMoveError("No target.");
-            if(attacker->actionPoints <= 0)
-                throw InvalidMoveError("Not enough action points.");
-
-            attacker->attack(*target);
-            if(!target->isAlive()) {
-                playerUnitPositions[target->player].erase(target->position);
-                units.set(target->position, {});
+            UnitHandle attacker = unitHandleAt(pAttacker), target = unitHandleAt(pTarget);
+            undo.unit = attacker;
+            undo.target = target;
+            undo.targetType = unitPool.type[target];
+            undo.targetHealth = unitPool.health[target];
+
+            --unitPool.actionPoints[attacker];
+            int &targetHealth = unitPool.health[target];
+            targetHealth = std::max(0, targetHealth - UnitType::registry.stats().damage(unitPool.type[attacker], unitPool.type[target]));
+            if(targetHealth <= 0) {
+                setUnoccupied(pTarget, unitPool.player[target]);
+                units.set(pTarget, NO_UNIT);
+                unitPool.remove(target);
             }
         }
         break;
 
         case MoveType::END_TURN:
+            if(outUndo)
+                // in the same order endTurn() replenishes them
+                for(size_t unit=0; unit<unitPool.capacity(); ++unit)
+                    if(unitPool.type[unit] != NO_UNIT_TYPE && unitPool.player[unit] == _currentPlayer) {
+                        savedPoints.push_back({unitPool.movementPoints[unit], unitPool.actionPoints[unit]});
+                        ++undo.savedEntries;
+                    }
             endTurn();
         break;
 
         case MoveType::SURRENDER:
-            forceSurrender(currentPlayer());
-        break;
-
-        // no need for error checking because FORCED_SURRENDER is only generated by the server
-        case MoveType::FORCED_SURRENDER: 
-            forceSurrender(playerUsernames[m.args[0]]);
+        case MoveType::FORCED_SURRENDER: {
+            int player = m.type == MoveType::SURRENDER ? _currentPlayer : m.args[0];
+            if(outUndo)
+                // in the same order forceSurrender() removes them
+                playerUnits[player].forEach([&](glm::ivec2 unitPos){
+                    UnitHandle unit = units.get(unitPos);
+                    removedUnits.push_back({unit, unitPool.type[unit]});
+                    ++undo.savedEntries;
+                });
+            forceSurrender(playerUsernames[player]);
+        }
         break;
 
         default:
-            throw InvalidMoveError("Not implemented.");
+            assert(false);
     }
+
+    if(outUndo)
+        *outUndo = undo;
 }
 
-void Game::moveUnitOneTile(const glm::ivec2 &from, const glm::ivec2 &to) {
-    if(abs(from.x - to.x) + abs(from.y - to.y) != 1)
-        throw InvalidMoveError("Discontinuous movement path.");
+void Game::unmakeMove(const MoveUndo &undo) {
+    ++_version;
+    switch(undo.type) {
+
+        case MoveType::MOVE_UNIT: {
+            if(undo.unit == NO_UNIT)
+                break;
+            glm::ivec2 to = unitPool.position[undo.unit];
+            unitPool.movementPoints[undo.unit] = undo.movementPoints;
+            if(to == undo.from)
+                break;
+
+            unitPool.position[undo.unit] = undo.from;
+            units.set(undo.from, undo.unit);
+            units.set(to, NO_UNIT);
+            setUnoccupied(to, undo.previousPlayer);
+            setOccupied(undo.from, undo.previousPlayer);
+        }
+        break;
+
+        case MoveType::ATTACK_UNIT: {
+            if(!unitPool.contains(undo.target)) {
+                glm::ivec2 position = unitPool.position[undo.target];
+                unitPool.restore(undo.target, undo.targetType);
+                units.set(position, undo.target);
+                setOccupied(position, unitPool.player[undo.target]);
+            }
+            unitPool.health[undo.target] = undo.targetHealth;
+            ++unitPool.actionPoints[undo.unit];
+        }
+        break;
+
+        case MoveType::END_TURN: {
+            assert(savedPoints.size() >= undo.savedEntries);
+            for(size_t unit=unitPool.capacity(); unit--;)
+                if(unitPool.type[unit] != NO_UNIT_TYPE && unitPool.player[unit] == undo.previousPlayer) {
+                    unitPool.movementPoints[unit] = savedPoints.back().movementPoints;
+                    unitPool.actionPoints[unit] = savedPoints.back().actionPoints;
+                    savedPoints.pop_back();
+                }
+        }
+        break;
 
-    auto unit = unitAt(from);
+        case MoveType::SURRENDER:
+        case MoveType::FORCED_SURRENDER: {
+            assert(removedUnits.size() >= undo.savedEntries);
+            for(int i=0; i<undo.savedEntries; ++i) {
+                RemovedUnit removed = removedUnits.back();
+                removedUnits.pop_back();
+                glm::ivec2 position = unitPool.position[removed.handle];
+                unitPool.restore(removed.handle, removed.type);
+                units.set(position, removed.handle);
+                setOccupied(position, unitPool.player[removed.handle]);
+            }
+        }
+        break;
 
-    if(unit == nullptr)
-        throw InvalidMoveError("Tile does not contain a unit.");
+        default:
+            assert(false);
+    }
+    _currentPlayer = undo.previousPlayer;
+}
 
-    if(unit->player != _currentPlayer)
-        throw InvalidMoveError("Player does not own the unit.");
+Game Game::stateCopy() const {
+    Game copy;
+    copy.terrain = terrain;
+    copy.movementCosts = movementCosts;
+    copy.units = units;
+    copy.unitPool = unitPool;
+    copy._currentPlayer = _currentPlayer;
+    copy._id = _id;
+    copy._version = _version;
+    copy.allUnits = allUnits;
+    copy.playerUnits = playerUnits;
+    copy.playerUsernames = playerUsernames;
+    copy.distanceOracle = distanceOracle;
+    return copy;
+}
 
-    if(unit->movementPoints <= 0)
-        throw InvalidMoveError("Movement points depleted.");
+// all occupancy changes go through these two, so that cached reachable tiles & threats are kept up to date
 
-    if(isTileOccupied(to))
-        throw InvalidMoveError("Destination tile is occupied.");
+void Game::setOccupied(const glm::ivec2 &position, int player) {
+    allUnits.set(position);
+    playerUnits[player].set(position);
+    reachabilityCache.invalidate(position);
+    threatMap.invalidate(position);
+}
 
-    if(!terrain.inBounds(to))
-        throw InvalidMoveError("Destination tile out of bounds.");
-    
-    unit->position = to;
-    unit->movementPoints -= terrain.get(from)->movementCost;
-    unit->movementPoints -= terrain.get(to)->movementCost;
-    units.set(to, unit);
-    units.set(from, {});
-    playerUnitPositions[_currentPlayer].erase(from);
-    playerUnitPositions[_currentPlayer].insert(to);
+void Game::setUnoccupied(const glm::ivec2 &position, int player) {
+    allUnits.reset(position);
+    playerUnits[player].reset(position);
+    reachabilityCache.invalidate(position);
+    threatMap.invalidate(position);
 }
 
-int Game::adjacentTileMovementCost(const glm::ivec2 &srcTile, const glm::ivec2 &dstTile) {
+int Game::adjacentTileMovementCost(const glm::ivec2 &srcTile, const glm::ivec2 &dstTile) const {
     assert(areTilesAdjacent(srcTile, dstTile));
-    return terrain.get(srcTile)->movementCost + terrain.get(dstTile)->movementCost;
+    return movementCosts.get(srcTile) + movementCosts.get(dstTile);
 }
 
-struct PathElement {
-    glm::ivec2 position;
-    int movementPointsLeft;
-};
-
-bool operator<(const PathElement &a, const PathElement &b) {
-    if(a.movementPointsLeft < b.movementPointsLeft) return true;
-    if(a.movementPointsLeft > b.movementPointsLeft) return false;
-    return IVec2Comparator()(a.position, b.position);
+ReachableTiles Game::findReachableTiles(const Unit &u) const {
+    UnitHandle handle = unitHandleAt(u.position);
+    // only units which are actually in the game can be cached
+    if(handle == NO_UNIT || unitPool.movementPoints[handle] != u.movementPoints)
+        return findReachableTiles(u, pathfindingScratch);
+    return findReachableTiles(handle);
 }
 
-std::map<glm::ivec2, glm::ivec2, IVec2Comparator> Game::findReachableTiles(const Unit &u) {
+ReachableTiles Game::findReachableTiles(UnitHandle unit) const {
+    assert(unitPool.contains(unit));
+    glm::ivec2 position = unitPool.position[unit];
+    int movementPoints = unitPool.movementPoints[unit];
 
-    // Standard Djikstra algorithm, nothing fancy here.
+    if(auto cached = reachabilityCache.find(unit, position, movementPoints))
+        return *cached;
+    auto tiles = pathfindingScratch.findReachableTiles(movementCosts, allUnits, position, movementPoints);
+    return reachabilityCache.store(unit, position, movementPoints, tiles, terrain.size());
+}
 
-    std::map<glm::ivec2, glm::ivec2, IVec2Comparator> predecessor;
-    predecessor[u.position] = u.position;
+ReachableTiles Game::findReachableTiles(const Unit &u, PathfindingScratch &scratch) const {
+    return scratch.findReachableTiles(movementCosts, allUnits, u.position, u.movementPoints);
+}
 
-    std::priority_queue<PathElement, std::vector<PathElement>> queue;
-    queue.push({u.position, u.movementPoints});
+void Game::findReachableTiles(int player, ReachabilityBatch &outRanges) const {
+    outRanges.units.clear();
+    playerUnits[player].forEach([&](glm::ivec2 position){
+        outRanges.units.push_back(units.get(position));
+    });
+    outRanges.prepare(1);
+    for(size_t i=0; i<outRanges.units.size(); ++i)
+        outRanges.add(0, i, findReachableTiles(outRanges.units[i]));
+    outRanges.pack();
+}
 
-    while(!queue.empty()) {
+void Game::findReachableTiles(int player, ReachabilityBatch &outRanges, Scheduler &scheduler) const {
+    outRanges.units.clear();
+    playerUnits[player].forEach([&](glm::ivec2 position){
+        outRanges.units.push_back(units.get(position));
+    });
+    // one worker per scheduler thread plus one for the calling thread
+    outRanges.prepare(scheduler.threadCount() + 1);
+
+    // the cache is only read here, writing to it from multiple threads would need locking
+    parallelFor(scheduler, 0, outRanges.units.size(), [&](size_t i){
+        size_t worker = scheduler.currentWorkerIndex();
+        UnitHandle unit = outRanges.units[i];
+        glm::ivec2 position = unitPool.position[unit];
+        int movementPoints = unitPool.movementPoints[unit];
+
+        if(auto cached = reachabilityCache.find(unit, position, movementPoints))
+            outRanges.add(worker, i, *cached);
+        else
+            outRanges.add(worker, i, outRanges.workers[worker].scratch.findReachableTiles(movementCosts, allUnits, position, movementPoints));
+    });
+    outRanges.pack();
+}
 
-        auto current = queue.top();
-        queue.pop();
+bool Game::findPath(const Unit &u, const glm::ivec2 &target, std::vector<glm::ivec2> &outPath) const {
+    UnitHandle handle = unitHandleAt(u.position);
+    if(handle == NO_UNIT || unitPool.movementPoints[handle] != u.movementPoints)
+        return pathfindingScratch.findPath(movementCosts, allUnits, distances(), u.position, target, u.movementPoints, outPath);
+    return findPath(handle, target, outPath);
+}
 
-        glm::ivec2 neighbourOffsets[4] = {glm::ivec2(-1,0), glm::ivec2(1,0), glm::ivec2(0,-1), glm::ivec2(0,1)};
+bool Game::findPath(UnitHandle unit, const glm::ivec2 &target, std::vector<glm::ivec2> &outPath) const {
+    assert(unitPool.contains(unit));
+    glm::ivec2 position = unitPool.position[unit];
+    int movementPoints = unitPool.movementPoints[unit];
 
-        if(current.movementPointsLeft > 0)
-            for(int i=0; i<4; ++i) {
-                glm::ivec2 next = current.position + neighbourOffsets[i];
-                if(
-                    terrain.inBounds(next) &&
-                    !isTileOccupied(next) &&
-                    predecessor.find(next) == predecessor.end()
-                ) {
-                    predecessor[next] = current.position;
-                    queue.push({next, current.movementPointsLeft - adjacentTileMovementCost(current.position, next)});
-                }
-            }
+    if(auto cached = reachabilityCache.find(unit, position, movementPoints)) {
+        if(!cached->contains(target)) {
+            outPath.clear();
+            return false;
+        }
+        cached->path(target, outPath);
+        return true;
+    }
+    return pathfindingScratch.findPath(movementCosts, allUnits, distances(), position, target, movementPoints, outPath);
+}
+
+// roughly how many A* searches cost as much as searching all reachable tiles of a unit
+static constexpr int pathQueriesPerFloodFill = 4;
+
+void Game::findPaths(const std::vector<PathQuery> &queries, PathBatch &outPaths) const {
+    outPaths.clear();
+    std::vector<int> queriesPerUnit(unitPool.capacity(), 0);
+    for(const auto &query : queries)
+        ++queriesPerUnit[query.unit];
+
+    std::vector<glm::ivec2> path;
+    for(const auto &query : queries) {
+        // once searched, the unit's reachable tiles are cached and findPath() just reads them
+        if(queriesPerUnit[query.unit] >= pathQueriesPerFloodFill)
+            findReachableTiles(query.unit);
+        findPath(query.unit, query.target, path);
+        outPaths.add(path);
     }
-    return predecessor;
 }
 
-template<typename T>
-void readContentTypeField(RxBuffer &rx, Field<const T*> &field) {
+const ThreatMap &Game::threats() const {
+    threatMap.update(*this);
+    return threatMap;
+}
+
+const DistanceOracle &Game::distances() const {
+    if(!distanceOracle)
+        distanceOracle = std::make_shared<DistanceOracle>(movementCosts);
+    return *distanceOracle;
+}
+
+void Game::onTerrainChanged() {
+    ++_version;
+    movementCosts = movementCostField(terrain);
+    // the oracle may be shared with the map & other games, so it's replaced (on first use) instead of updated
+    distanceOracle = nullptr;
+    reachabilityCache.clear();
+    threatMap = ThreatMap(playerCount(), terrain.size());
+}
+
+// Content type fields are sent as a grid of numeric IDs, (de)serialized in bulk
+
+// (the wire format uses full numeric IDs, even though they're stored in fewer bytes)
+
+template<typename T, typename ID>
+void readContentTypeField(RxBuffer &rx, Field<ID> &field) {
     auto width = rx.read<uint32_t>();
     auto height = rx.read<uint32_t>();
-    field = Field<const T*>(glm::ivec2(width, height));
-    for(uint32_t y=0; y<height; ++y)
-        for(uint32_t x=0; x<width; ++x) {
-            field.set(glm::ivec2(x,y), readContentType<T>(rx));
-        }
+
+    using NumericID = decltype(ContentType<T>::numericID);
+    if(static_cast<uint64_t>(width) * height > rx.size() / sizeof(NumericID))
+        throw std::out_of_range("");
+    std::vector<NumericID> ids(static_cast<size_t>(width) * height);
+    readArray(rx, ids.data(), ids.size());
+
+    const auto &registry = ContentType<T>::registry;
+    field = Field<ID>(glm::ivec2(width, height));
+    auto tile = field.begin();
+    for(auto numericID : ids) {
+        if(!registry.contains(numericID))
+            throw ProtocolError("Unknown numeric ID.");
+        *tile++ = static_cast<ID>(numericID);
+    }
+}
+
+template<typename T, typename ID>
+void writeContentTypeField(TxBuffer &tx, const Field<ID> &field) {
+    auto size = field.size();
+    tx << size.x << size.y;
+
+    std::vector<decltype(ContentType<T>::numericID)> ids(field.begin(), field.end());
+    writeArray(tx, ids.data(), ids.size());
 }
 
 RxBuffer &operator>>(RxBuffer &rx, Game &game) {
@@ -244,19 +615,30 @@ RxBuffer &operator>>(RxBuffer &rx, Game &game) {
     auto playerCount = game.playerUsernames.size();
 
     readContentTypeField<TerrainType>(rx, game.terrain);
+    game.movementCosts = movementCostField(game.terrain);
+    game.distanceOracle = nullptr;
 
     auto unitCount = rx.read<uint32_t>();
-    game.playerUnitPositions.resize(playerCount);
-    game.units = Field<std::shared_ptr<Unit>>(game.terrain.size());
+    game.allUnits = Bitboard(game.terrain.size());
+    game.playerUnits.assign(playerCount, game.allUnits);
+    game.units = Field<UnitHandle>(game.terrain.size(), NO_UNIT);
+    game.unitPool.clear();
+    game.reachabilityCache.clear();
+    game.threatMap = ThreatMap(static_cast<int>(playerCount), game.terrain.size());
+    if(unitCount > UnitPool::maxUnits)
+        throw std::out_of_range("Too many units!");
 
     for(auto i=0; i<unitCount; ++i) {
         auto unit = rx.read<Unit>();
 
         if(!game.units.inBounds(unit.position))
             throw std::out_of_range("Unit position out of range!");
+        if(unit.player < 0 || unit.player >= static_cast<int>(playerCount))
+            throw std::out_of_range("Unit owner out of range!");
+        if(game.isTileOccupied(unit.position))
+            throw ProtocolError("Multiple units on one tile.");
 
-        game.units.set(unit.position, std::make_shared<Unit>(unit));
-        game.playerUnitPositions.at(unit.player).insert(unit.position);
+        game.spawn(unit);
     }
 
     return rx;
@@ -270,21 +652,13 @@ TxBuffer &operator<<(TxBuffer &tx, const Game &game) {
     tx << game.playerUsernames;
 
     // terrain
-    tx << game.terrain;
+    writeContentTypeField<TerrainType>(tx, game.terrain);
     
     // units
-    uint32_t unitCount = std::transform_reduce(
-        game.playerUnitPositions.begin(), 
-        game.playerUnitPositions.end(), 
-        0, 
-        [](auto a, auto b){return a+b;}, 
-        [](auto &v){return v.size();}
-    );
-
-    tx << unitCount;
-    for(const auto &positionList : game.playerUnitPositions)
-        for(auto position : positionList)
-            tx << *game.unitAt(position);
+    tx << static_cast<uint32_t>(game.unitPool.size());
+    for(UnitHandle unit=0; unit<game.unitPool.capacity(); ++unit)
+        if(game.unitPool.contains(unit))
+            tx << game.unitPool.get(unit);
 
     return tx;
 }
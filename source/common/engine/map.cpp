@@ -12,4 +12,8 @@ Map::Map() : Map("", glm::ivec2(0,0), 0, nullptr) {}
 
 int Map::playerCount() const {
     return static_cast<int>(startingUnits.size());
+}
+
+void Map::onRegistered() {
+    distances = std::make_shared<DistanceOracle>(movementCostField(terrainIDField(terrain)));
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 Move Move::moveUnit(const std::vector<glm::ivec2> &unitPath) {
     Move result;
     result.type = MoveType::MOVE_UNIT;
+    result.args.reserve(2*unitPath.size());
     for(auto pos : unitPath) {
         result.args.push_back(pos.x);
         result.args.push_back(pos.y);
@@ -18,10 +19,10 @@ Move Move::attackUnit(const Unit &attacker, const Unit &target) {
     return result;
 }
 Move Move::endTurn() {
-    return {MoveType::END_TURN};
+    return {MoveType::END_TURN, {}};
 }
 Move Move::surrender() {
-    return {MoveType::SURRENDER};
+    return {MoveType::SURRENDER, {}};
 }
 Move Move::forceSurrender(int playerIndex) {
     return {MoveType::FORCED_SURRENDER, {playerIndex}};
@@ -29,12 +30,112 @@ Move Move::forceSurrender(int playerIndex) {
 
 DEFINE_ENUM_SERDE(MoveType)
 
+const char *moveStatusMessage(MoveStatus status) {
+    switch(status) {
+        case MoveStatus::OK:                   return "OK.";
+        case MoveStatus::MALFORMED:            return "Malformed move description.";
+        case MoveStatus::DISCONTINUOUS_PATH:   return "Discontinuous movement path.";
+        case MoveStatus::NO_UNIT:              return "Tile does not contain a unit.";
+        case MoveStatus::NOT_OWNED:            return "Player does not own the unit.";
+        case MoveStatus::NO_MOVEMENT_POINTS:   return "Movement points depleted.";
+        case MoveStatus::DESTINATION_OCCUPIED: return "Destination tile is occupied.";
+        case MoveStatus::OUT_OF_BOUNDS:        return "Tile out of bounds.";
+        case MoveStatus::NO_TARGET:            return "No target.";
+        case MoveStatus::NO_ACTION_POINTS:     return "Not enough action points.";
+        case MoveStatus::OUT_OF_RANGE:         return "Target out of attack range.";
+        case MoveStatus::FRIENDLY_TARGET:      return "Units can't attack their own player's units.";
+        case MoveStatus::NOT_IMPLEMENTED:      return "Not implemented.";
+    }
+    return "Unknown move status.";
+}
+
+// MOVE_UNIT paths are sent as the number of tiles, the first tile and then one 2-bit direction 
+// per step, packed 4 steps per byte (the lowest bits hold the first step).
+// Other moves only have a few arguments, which are sent as a 1 byte count followed by the values.
+
+static const glm::ivec2 stepDirections[4] = {glm::ivec2(1,0), glm::ivec2(-1,0), glm::ivec2(0,1), glm::ivec2(0,-1)};
+
+static uint8_t encodeStep(const glm::ivec2 &from, const glm::ivec2 &to) {
+    for(uint8_t direction=0; direction<4; ++direction)
+        if(to - from == stepDirections[direction])
+            return direction;
+    throw InvalidMoveError(MoveStatus::DISCONTINUOUS_PATH);
+}
+
+static void writePath(TxBuffer &tx, const Move &move) {
+    const auto &args = move.args;
+    if(args.size() % 2 != 0)
+        throw InvalidMoveError(MoveStatus::MALFORMED);
+    size_t tileCount = args.size() / 2;
+    if(tileCount > UINT16_MAX)
+        throw InvalidMoveError("Movement path too long.");
+
+    tx << static_cast<uint16_t>(tileCount);
+    if(tileCount == 0)
+        return;
+    tx << args[0] << args[1];
+
+    uint8_t packed = 0;
+    for(size_t step=1; step<tileCount; ++step) {
+        glm::ivec2 from(args[2*step-2], args[2*step-1]), to(args[2*step], args[2*step+1]);
+        size_t slot = (step-1) % 4;
+        packed |= encodeStep(from, to) << (2*slot);
+        if(slot == 3 || step == tileCount-1) {
+            tx << packed;
+            packed = 0;
+        }
+    }
+}
+
+static void readPath(RxBuffer &rx, Move &move) {
+    auto tileCount = rx.read<uint16_t>();
+    move.args.clear();
+    if(tileCount == 0)
+        return;
+    // first tile + packed steps, checked up front so that a bogus count can't make us allocate
+    if(2*sizeof(int32_t) + (tileCount-1 + 3)/4 > rx.size())
+        throw std::out_of_range("");
+    move.args.reserve(2*tileCount);
+
+    glm::ivec2 tile;
+    rx >> tile.x >> tile.y;
+    move.args.push_back(tile.x);
+    move.args.push_back(tile.y);
+
+    uint8_t packed = 0;
+    for(size_t step=1; step<tileCount; ++step) {
+        size_t slot = (step-1) % 4;
+        if(slot == 0)
+            rx >> packed;
+        tile += stepDirections[(packed >> (2*slot)) & 3];
+        move.args.push_back(tile.x);
+        move.args.push_back(tile.y);
+    }
+}
+
 RxBuffer &operator>>(RxBuffer &rx, Move &result) {
-    return (rx >> result.type >> result.args);
+    rx >> result.type;
+    if(result.type == MoveType::MOVE_UNIT) {
+        readPath(rx, result);
+    } else {
+        auto count = rx.read<uint8_t>();
+        result.args.resize(count);
+        readArray(rx, result.args.data(), count);
+    }
+    return rx;
 }
 
 TxBuffer &operator<<(TxBuffer &tx, const Move &result) {
-    return (tx << result.type << result.args);
+    tx << result.type;
+    if(result.type == MoveType::MOVE_UNIT) {
+        writePath(tx, result);
+    } else {
+        if(result.args.size() > UINT8_MAX)
+            throw InvalidMoveError(MoveStatus::MALFORMED);
+        tx << static_cast<uint8_t>(result.args.size());
+        writeArray(tx, result.args.data(), result.args.size());
+    }
+    return tx;
 }
 
 void RecordingMoveAcceptorProxy::makeMove(const Move &m) {
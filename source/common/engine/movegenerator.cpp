@@ -0,0 +1,86 @@
+#include <engine/movegenerator.h>
+
+#include <cassert>
+#include <cstdlib>
+
+#include <engine/game.h>
+
+void MoveGenerator::generate(const Game &game, std::vector<GeneratedMove> &outMoves) {
+    outMoves.clear();
+
+    const auto &pool = game.unitPool;
+    const auto &stats = UnitType::registry.stats();
+    int player = game.currentPlayerIndex();
+    const Bitboard &allUnits = game.occupancy(), &ownUnits = game.occupancy(player);
+
+    game.findReachableTiles(player, reachability);
+    rangeOfUnit.resize(pool.capacity());
+
+    for(size_t i=0; i<reachability.size(); ++i) {
+        UnitHandle unit = reachability.unit(i);
+        rangeOfUnit[unit] = static_cast<uint16_t>(i);
+        glm::ivec2 position = pool.position[unit];
+
+        ReachableTiles tiles = reachability[i];
+        for(uint32_t tile=0; tile<tiles.size(); ++tile)
+            if(tiles.begin()[tile].position != position)
+                outMoves.push_back({MoveType::MOVE_UNIT, unit, NO_UNIT, tile});
+
+        if(pool.actionPoints[unit] <= 0)
+            continue;
+        // enemy units within a taxicab circle around the unit
+        int range = stats.attackRange[pool.type[unit]];
+        for(int dy=-range; dy<=range; ++dy) {
+            int width = range - std::abs(dy);
+            for(int dx=-width; dx<=width; ++dx) {
+                glm::ivec2 target = position + glm::ivec2(dx, dy);
+                if(allUnits.testOr(target, false) && !ownUnits.test(target))
+                    outMoves.push_back({MoveType::ATTACK_UNIT, unit, game.unitHandleAt(target)});
+            }
+        }
+    }
+
+    outMoves.push_back({MoveType::END_TURN});
+    outMoves.push_back({MoveType::SURRENDER});
+}
+
+ReachableTiles MoveGenerator::reachableTiles(UnitHandle unit) const {
+    assert(unit < rangeOfUnit.size() && reachability.unit(rangeOfUnit[unit]) == unit);
+    return reachability[rangeOfUnit[unit]];
+}
+
+glm::ivec2 MoveGenerator::destination(const GeneratedMove &move) const {
+    assert(move.type == MoveType::MOVE_UNIT);
+    ReachableTiles tiles = reachableTiles(move.unit);
+    assert(move.destination < tiles.size());
+    return tiles.begin()[move.destination].position;
+}
+
+void MoveGenerator::path(const GeneratedMove &move, std::vector<glm::ivec2> &outPath) const {
+    reachableTiles(move.unit).path(destination(move), outPath);
+}
+
+Move MoveGenerator::toMove(const Game &game, const GeneratedMove &move) const {
+    const auto &pool = game.unitPool;
+    switch(move.type) {
+
+        case MoveType::MOVE_UNIT:
+            path(move, pathScratch);
+            return Move::moveUnit(pathScratch);
+
+        case MoveType::ATTACK_UNIT: {
+            glm::ivec2 attacker = pool.position[move.unit], target = pool.position[move.target];
+            return {MoveType::ATTACK_UNIT, {attacker.x, attacker.y, target.x, target.y}};
+        }
+
+        case MoveType::END_TURN:
+            return Move::endTurn();
+
+        case MoveType::SURRENDER:
+            return Move::surrender();
+
+        default:
+            assert(false);
+            return Move::endTurn();
+    }
+}
@@ -0,0 +1,310 @@
+#include <engine/pathfinding.h>
+
+#include <algorithm>
+#include <cassert>
+
+static bool rowMajorLess(const glm::ivec2 &lhs, const glm::ivec2 &rhs) {
+    return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+}
+
+const ReachableTile *ReachableTiles::find(const glm::ivec2 &position) const {
+    auto it = std::lower_bound(begin(), end(), position, [](const ReachableTile &tile, const glm::ivec2 &position){
+        return rowMajorLess(tile.position, position);
+    });
+    return (it != end() && it->position == position) ? it : nullptr;
+}
+
+bool ReachableTiles::contains(const glm::ivec2 &position) const {
+    return find(position) != nullptr;
+}
+
+void ReachableTiles::path(const glm::ivec2 &destination, std::vector<glm::ivec2> &outPath) const {
+    outPath.clear();
+    const ReachableTile *tile = find(destination);
+    assert(tile != nullptr);
+    outPath.push_back(tile->position);
+    while(tile->predecessor != tile->position) {
+        tile = find(tile->predecessor);
+        outPath.push_back(tile->position);
+    }
+    std::reverse(outPath.begin(), outPath.end());
+}
+
+void PathfindingScratch::prepare(glm::ivec2 mapSize) {
+    size_t tileCount = static_cast<size_t>(mapSize.x) * mapSize.y;
+    if(distance.size() != tileCount) {
+        distance.assign(tileCount, 0);
+        predecessor.assign(tileCount, 0);
+        epoch.assign(tileCount, 0);
+        currentEpoch = 0;
+    }
+    // epoch 0 is never current, so after wrapping around all entries have to be invalidated once
+    if(++currentEpoch == 0) {
+        std::fill(epoch.begin(), epoch.end(), 0);
+        currentEpoch = 1;
+    }
+}
+
+ReachableTiles PathfindingScratch::findReachableTiles(
+    const Field<uint16_t> &movementCosts,
+    const Bitboard &blocked,
+    const glm::ivec2 &start,
+    int movementPoints
+) {
+    assert(movementCosts.inBounds(start));
+    assert(movementCosts.size() == blocked.size());
+
+    int maxTerrainCost = TerrainType::registry.stats().maxMovementCost;
+    prepare(movementCosts.size());
+    // distances in the queue never differ by more than one step, so one bucket per possible step cost is enough
+    if(buckets.size() != static_cast<size_t>(2 * maxTerrainCost) + 1)
+        buckets.resize(2 * maxTerrainCost + 1);
+    result.clear();
+
+    const uint16_t *costs = movementCosts.data();
+    const glm::ivec2 neighbourOffsets[4] = {glm::ivec2(-1,0), glm::ivec2(1,0), glm::ivec2(0,-1), glm::ivec2(0,1)};
+    const size_t bucketCount = buckets.size();
+
+    uint32_t startIndex = static_cast<uint32_t>(movementCosts.index(start));
+    distance[startIndex] = 0;
+    predecessor[startIndex] = startIndex;
+    epoch[startIndex] = currentEpoch;
+    buckets[0].push_back(startIndex);
+    size_t queued = 1;
+
+    for(int current = 0; queued > 0; ++current) {
+        auto &bucket = buckets[current % bucketCount];
+        // zero cost steps append to the bucket being processed, hence no iterators
+        for(size_t i=0; i<bucket.size(); ++i) {
+            uint32_t tile = bucket[i];
+            --queued;
+            // stale entry, the tile was reached more cheaply after being queued
+            if(distance[tile] != current)
+                continue;
+
+            glm::ivec2 position = blocked.position(tile);
+            result.push_back({position, blocked.position(predecessor[tile]), movementPoints - current});
+
+            // a unit can keep moving for as long as it has any movement points left
+            if(current >= movementPoints)
+                continue;
+
+            int tileCost = costs[tile];
+            for(const auto &offset : neighbourOffsets) {
+                glm::ivec2 next = position + offset;
+                if(!movementCosts.inBounds(next) || blocked.test(next))
+                    continue;
+                uint32_t nextIndex = static_cast<uint32_t>(movementCosts.index(next));
+                int nextDistance = current + tileCost + costs[nextIndex];
+                if(epoch[nextIndex] != currentEpoch || nextDistance < distance[nextIndex]) {
+                    epoch[nextIndex] = currentEpoch;
+                    distance[nextIndex] = nextDistance;
+                    predecessor[nextIndex] = tile;
+                    buckets[nextDistance % bucketCount].push_back(nextIndex);
+                    ++queued;
+                }
+            }
+        }
+        bucket.clear();
+    }
+
+    std::sort(result.begin(), result.end(), [](const ReachableTile &lhs, const ReachableTile &rhs){
+        return rowMajorLess(lhs.position, rhs.position);
+    });
+    return ReachableTiles(result.data(), result.size());
+}
+
+void markDependencies(const ReachableTiles &tiles, Bitboard &outDependencies) {
+    const glm::ivec2 neighbourOffsets[4] = {glm::ivec2(-1,0), glm::ivec2(1,0), glm::ivec2(0,-1), glm::ivec2(0,1)};
+    for(const auto &tile : tiles) {
+        outDependencies.set(tile.position);
+        if(tile.movementPointsLeft > 0)
+            for(const auto &offset : neighbourOffsets)
+                if(outDependencies.inBounds(tile.position + offset))
+                    outDependencies.set(tile.position + offset);
+    }
+}
+
+bool PathfindingScratch::findPath(
+    const Field<uint16_t> &movementCosts,
+    const Bitboard &blocked,
+    const DistanceOracle &distances,
+    const glm::ivec2 &start,
+    const glm::ivec2 &target,
+    int movementPoints,
+    std::vector<glm::ivec2> &outPath
+) {
+    assert(movementCosts.inBounds(start));
+    assert(movementCosts.size() == blocked.size() && movementCosts.size() == distances.size());
+
+    outPath.clear();
+    if(!movementCosts.inBounds(target) || (target != start && blocked.test(target)))
+        return false;
+
+    prepare(movementCosts.size());
+    heap.clear();
+    auto heapOrder = [](const HeapEntry &lhs, const HeapEntry &rhs){
+        // among equal estimates prefer the tile closest to the target
+        return lhs.estimate > rhs.estimate || (lhs.estimate == rhs.estimate && lhs.distance < rhs.distance);
+    };
+
+    const uint16_t *costs = movementCosts.data();
+    const glm::ivec2 neighbourOffsets[4] = {glm::ivec2(-1,0), glm::ivec2(1,0), glm::ivec2(0,-1), glm::ivec2(0,1)};
+
+    uint32_t startIndex = static_cast<uint32_t>(movementCosts.index(start));
+    uint32_t targetIndex = static_cast<uint32_t>(movementCosts.index(target));
+    distance[startIndex] = 0;
+    predecessor[startIndex] = startIndex;
+    epoch[startIndex] = currentEpoch;
+    // the heuristic is the oracle's bound rather than taxicab distance * cheapest step cost: it's admissible too,
+    // and at least as tight (exact on small maps, max(taxicab bound, landmark bounds) on larger ones)
+    heap.push_back({distances.lowerBound(start, target), 0, startIndex});
+
+    while(!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), heapOrder);
+        HeapEntry current = heap.back();
+        heap.pop_back();
+        // stale entry, the tile was reached more cheaply after being queued
+        if(current.distance != distance[current.tile])
+            continue;
+
+        if(current.tile == targetIndex) {
+            for(uint32_t tile = targetIndex; tile != startIndex; tile = predecessor[tile])
+                outPath.push_back(blocked.position(tile));
+            outPath.push_back(start);
+            std::reverse(outPath.begin(), outPath.end());
+            return true;
+        }
+
+        // a unit can keep moving for as long as it has any movement points left
+        if(current.distance >= movementPoints)
+            continue;
+
+        glm::ivec2 position = blocked.position(current.tile);
+        int tileCost = costs[current.tile];
+        for(const auto &offset : neighbourOffsets) {
+            glm::ivec2 next = position + offset;
+            if(!movementCosts.inBounds(next) || blocked.test(next))
+                continue;
+            uint32_t nextIndex = static_cast<uint32_t>(movementCosts.index(next));
+            int nextDistance = current.distance + tileCost + costs[nextIndex];
+            if(epoch[nextIndex] != currentEpoch || nextDistance < distance[nextIndex]) {
+                epoch[nextIndex] = currentEpoch;
+                distance[nextIndex] = nextDistance;
+                predecessor[nextIndex] = current.tile;
+                heap.push_back({nextDistance + distances.lowerBound(next, target), nextDistance, nextIndex});
+                std::push_heap(heap.begin(), heap.end(), heapOrder);
+            }
+        }
+    }
+    return false;
+}
+
+void PathBatch::clear() {
+    tiles.clear();
+    offsets.assign(1, 0);
+}
+
+void PathBatch::add(const std::vector<glm::ivec2> &path) {
+    tiles.insert(tiles.end(), path.begin(), path.end());
+    offsets.push_back(static_cast<uint32_t>(tiles.size()));
+}
+
+size_t PathBatch::size() const {
+    return offsets.size() - 1;
+}
+
+bool PathBatch::found(size_t i) const {
+    return begin(i) != end(i);
+}
+
+const glm::ivec2 *PathBatch::begin(size_t i) const {
+    assert(i < size());
+    return tiles.data() + offsets[i];
+}
+
+const glm::ivec2 *PathBatch::end(size_t i) const {
+    assert(i < size());
+    return tiles.data() + offsets[i+1];
+}
+
+size_t ReachabilityBatch::size() const {
+    return units.size();
+}
+
+UnitHandle ReachabilityBatch::unit(size_t i) const {
+    assert(i < size());
+    return units[i];
+}
+
+ReachableTiles ReachabilityBatch::operator[](size_t i) const {
+    assert(i < size());
+    return ReachableTiles(tiles.data() + offsets[i], offsets[i+1] - offsets[i]);
+}
+
+void ReachabilityBatch::prepare(size_t workerCount) {
+    tiles.clear();
+    offsets.clear();
+    spans.resize(units.size());
+    if(workers.size() < workerCount)
+        workers.resize(workerCount);
+    for(auto &worker : workers)
+        worker.tiles.clear();
+}
+
+void ReachabilityBatch::add(size_t worker, size_t i, const ReachableTiles &result) {
+    auto &workerTiles = workers[worker].tiles;
+    spans[i] = {static_cast<uint32_t>(worker), static_cast<uint32_t>(workerTiles.size()), static_cast<uint32_t>(result.size())};
+    workerTiles.insert(workerTiles.end(), result.begin(), result.end());
+}
+
+void ReachabilityBatch::pack() {
+    offsets.resize(units.size() + 1);
+    offsets[0] = 0;
+    for(size_t i=0; i<units.size(); ++i)
+        offsets[i+1] = offsets[i] + spans[i].count;
+
+    tiles.resize(offsets.back());
+    for(size_t i=0; i<units.size(); ++i) {
+        const auto *first = workers[spans[i].worker].tiles.data() + spans[i].offset;
+        std::copy(first, first + spans[i].count, tiles.begin() + offsets[i]);
+    }
+}
+
+std::optional<ReachableTiles> ReachabilityCache::find(UnitHandle unit, const glm::ivec2 &position, int movementPoints) const {
+    if(unit >= entries.size())
+        return std::nullopt;
+    const Entry &entry = entries[unit];
+    // handles get reused, but the result only depends on position & movement points anyway
+    if(!entry.valid || entry.position != position || entry.movementPoints != movementPoints)
+        return std::nullopt;
+    return ReachableTiles(entry.tiles.data(), entry.tiles.size());
+}
+
+ReachableTiles ReachabilityCache::store(UnitHandle unit, const glm::ivec2 &position, int movementPoints, const ReachableTiles &tiles, glm::ivec2 mapSize) {
+    if(unit >= entries.size())
+        entries.resize(unit + 1);
+    Entry &entry = entries[unit];
+    entry.valid = true;
+    entry.position = position;
+    entry.movementPoints = movementPoints;
+    entry.tiles.assign(tiles.begin(), tiles.end());
+
+    if(entry.dependencies.size() != mapSize)
+        entry.dependencies = Bitboard(mapSize);
+    else
+        entry.dependencies.clear();
+    markDependencies(tiles, entry.dependencies);
+    return ReachableTiles(entry.tiles.data(), entry.tiles.size());
+}
+
+void ReachabilityCache::invalidate(const glm::ivec2 &tile) {
+    for(auto &entry : entries)
+        if(entry.valid && entry.dependencies.testOr(tile, false))
+            entry.valid = false;
+}
+
+void ReachabilityCache::clear() {
+    for(auto &entry : entries)
+        entry.valid = false;
+}
@@ -0,0 +1,236 @@
+#include <engine/search.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+// keeps the memory used by one search thread bounded (~40 bytes per node),
+// once the tree is this big leaves are no longer expanded, only played out
+static constexpr size_t maxTreeNodes = 1 << 16;
+// UCT exploration constant
+static constexpr double exploration = 1.4;
+
+struct SearchEngine::Tree {
+    std::vector<Node> nodes;
+    // nodes on the path from the root to the current leaf
+    std::vector<uint32_t> visited;
+    std::vector<MoveUndo> undo;
+
+    MoveGenerator generator;
+    std::vector<GeneratedMove> moves;
+    std::vector<glm::ivec2> path;
+    std::mt19937_64 rng;
+};
+
+SearchEngine::SearchEngine(Scheduler &scheduler) : scheduler(scheduler) {}
+
+// true once `player` has either won or lost
+static bool isDecided(const Game &game, int player) {
+    int remaining = game.unitCount(player);
+    return remaining == 0 || remaining == game.occupancy().count();
+}
+
+// 1 = `player` won, 0 = `player` lost, otherwise the player's share of all remaining units (weighted by health)
+static double evaluate(const Game &game, int player) {
+    const auto &pool = game.unitPool;
+    const auto &stats = UnitType::registry.stats();
+
+    double own = 0, total = 0;
+    for(UnitHandle unit=0; unit<pool.capacity(); ++unit)
+        if(pool.contains(unit)) {
+            double value = 1.0 + static_cast<double>(pool.health[unit]) / stats.maxHealth[pool.type[unit]];
+            total += value;
+            if(pool.player[unit] == player)
+                own += value;
+        }
+    return total > 0 ? own / total : 0.0;
+}
+
+Move SearchEngine::findMove(const Game &game, const SearchLimits &limits, uint64_t seed) {
+    // more trees than threads would be searched one after another, each one eating into the same time budget
+    int threadCount = std::clamp(limits.threadCount, 1, scheduler.threadCount());
+    std::vector<Tree> trees(threadCount);
+    TimePoint deadline = Clock::now() + limits.timeBudget;
+
+    TaskGroup group(scheduler);
+    for(int i=1; i<threadCount; ++i)
+        group.run([&, i]{
+            search(game, limits, deadline, seed + i, trees[i]);
+        });
+    search(game, limits, deadline, seed, trees[0]);
+    group.wait();
+
+    // every tree shuffled the root's children differently, so they are matched by the move
+    auto sameEdge = [](const Edge &a, const Edge &b) {
+        return a.type == b.type && a.unit == b.unit && a.target == b.target && a.destination == b.destination;
+    };
+    const Node &root = trees[0].nodes[0];
+    if(root.childCount == 0)
+        return Move::endTurn();
+    uint32_t best = root.firstChild, bestVisits = 0;
+    for(uint32_t child=root.firstChild; child<root.firstChild+root.childCount; ++child) {
+        const Edge &edge = trees[0].nodes[child].edge;
+        uint32_t visits = 0;
+        for(const Tree &tree : trees) {
+            const Node &otherRoot = tree.nodes[0];
+            for(uint32_t other=otherRoot.firstChild; other<otherRoot.firstChild+otherRoot.childCount; ++other)
+                if(sameEdge(tree.nodes[other].edge, edge))
+                    visits += tree.nodes[other].visits;
+        }
+        if(visits > bestVisits) {
+            best = child;
+            bestVisits = visits;
+        }
+    }
+
+    const Edge &edge = trees[0].nodes[best].edge;
+    const auto &pool = game.unitPool;
+    switch(edge.type) {
+        case MoveType::MOVE_UNIT: {
+            std::vector<glm::ivec2> path;
+            game.findPath(edge.unit, edge.destination, path);
+            return Move::moveUnit(path);
+        }
+        case MoveType::ATTACK_UNIT: {
+            glm::ivec2 attacker = pool.position[edge.unit], target = pool.position[edge.target];
+            return {MoveType::ATTACK_UNIT, {attacker.x, attacker.y, target.x, target.y}};
+        }
+        default:
+            return Move::endTurn();
+    }
+}
+
+void SearchEngine::search(const Game &original, const SearchLimits &limits, TimePoint deadline, uint64_t seed, Tree &tree) {
+    Game game = original.stateCopy();
+    int me = game.currentPlayerIndex();
+    tree.rng.seed(seed);
+
+    auto makeEdge = [&](const Edge &edge) {
+        const auto &pool = game.unitPool;
+        Move move;
+        switch(edge.type) {
+            case MoveType::MOVE_UNIT: {
+                [[maybe_unused]] bool found = game.findPath(edge.unit, edge.destination, tree.path);
+                assert(found);
+                move = Move::moveUnit(tree.path);
+            }
+            break;
+            case MoveType::ATTACK_UNIT: {
+                glm::ivec2 attacker = pool.position[edge.unit], target = pool.position[edge.target];
+                move = {MoveType::ATTACK_UNIT, {attacker.x, attacker.y, target.x, target.y}};
+            }
+            break;
+            default:
+                move = Move::endTurn();
+        }
+        tree.undo.emplace_back();
+        [[maybe_unused]] MoveStatus status = game.tryMakeMove(move, tree.undo.back());
+        assert(status == MoveStatus::OK);
+    };
+
+    // children of a node are all legal moves except surrendering, attacks are tried first
+    auto expand = [&](uint32_t node) {
+        tree.generator.generate(game, tree.moves);
+        uint32_t firstChild = static_cast<uint32_t>(tree.nodes.size());
+        for(const auto &generated : tree.moves) {
+            if(generated.type == MoveType::SURRENDER)
+                continue;
+            Node child;
+            child.edge = {generated.type, generated.unit, generated.target, glm::ivec2(0)};
+            if(generated.type == MoveType::MOVE_UNIT)
+                child.edge.destination = tree.generator.destination(generated);
+            tree.nodes.push_back(child);
+        }
+        auto children = tree.nodes.begin() + firstChild;
+        std::shuffle(children, tree.nodes.end(), tree.rng);
+        std::stable_partition(children, tree.nodes.end(), [](const Node &node) {
+            return node.edge.type == MoveType::ATTACK_UNIT;
+        });
+        tree.nodes[node].firstChild = firstChild;
+        tree.nodes[node].childCount = static_cast<uint32_t>(tree.nodes.size()) - firstChild;
+        tree.nodes[node].expanded = true;
+    };
+
+    tree.nodes.clear();
+    tree.nodes.emplace_back();
+    expand(0);
+
+    for(size_t playouts=0; playouts<limits.maxPlayouts && (playouts == 0 || Clock::now() < deadline); ++playouts) {
+        tree.visited.assign(1, 0);
+        tree.undo.clear();
+
+        // selection
+        uint32_t node = 0;
+        while(tree.nodes[node].expanded && tree.nodes[node].childCount > 0 && !isDecided(game, me)) {
+            const Node &parent = tree.nodes[node];
+            bool ourMove = game.currentPlayerIndex() == me;
+            double logVisits = std::log(std::max<uint32_t>(parent.visits, 1));
+            uint32_t best = parent.firstChild;
+            double bestScore = -1;
+            for(uint32_t child=parent.firstChild; child<parent.firstChild+parent.childCount; ++child) {
+                const Node &candidate = tree.nodes[child];
+                if(candidate.visits == 0) {
+                    best = child;
+                    break;
+                }
+                double mean = candidate.reward / candidate.visits;
+                double score = (ourMove ? mean : 1 - mean) + exploration * std::sqrt(logVisits / candidate.visits);
+                if(score > bestScore) {
+                    best = child;
+                    bestScore = score;
+                }
+            }
+            node = best;
+            makeEdge(tree.nodes[node].edge);
+            tree.visited.push_back(node);
+        }
+
+        // expansion, leaves are expanded on their second visit
+        if(!tree.nodes[node].expanded && tree.nodes[node].visits > 0 && tree.nodes.size() < maxTreeNodes && !isDecided(game, me)) {
+            expand(node);
+            if(tree.nodes[node].childCount > 0) {
+                node = tree.nodes[node].firstChild + static_cast<uint32_t>(tree.rng() % tree.nodes[node].childCount);
+                makeEdge(tree.nodes[node].edge);
+                tree.visited.push_back(node);
+            }
+        }
+
+        // playout: attack when possible, end the turn now and then, otherwise move somewhere at random
+        for(int i=0; i<limits.playoutLength && !isDecided(game, me); ++i) {
+            tree.generator.generate(game, tree.moves);
+            size_t attacks = std::count_if(tree.moves.begin(), tree.moves.end(), [](const GeneratedMove &move) {
+                return move.type == MoveType::ATTACK_UNIT;
+            });
+
+            const GeneratedMove *chosen = nullptr;
+            if(attacks > 0 && tree.rng() % 2 == 0) {
+                size_t index = tree.rng() % attacks;
+                for(const auto &move : tree.moves)
+                    if(move.type == MoveType::ATTACK_UNIT && index-- == 0) {
+                        chosen = &move;
+                        break;
+                    }
+            } else if(tree.rng() % 6 != 0) {
+                // the last two moves are END_TURN & SURRENDER
+                if(tree.moves.size() > 2)
+                    chosen = &tree.moves[tree.rng() % (tree.moves.size() - 2)];
+            }
+            Move move = chosen ? tree.generator.toMove(game, *chosen) : Move::endTurn();
+            tree.undo.emplace_back();
+            [[maybe_unused]] MoveStatus status = game.tryMakeMove(move, tree.undo.back());
+            assert(status == MoveStatus::OK);
+        }
+
+        // backpropagation
+        double reward = evaluate(game, me);
+        for(uint32_t visited : tree.visited) {
+            ++tree.nodes[visited].visits;
+            tree.nodes[visited].reward += reward;
+        }
+        while(!tree.undo.empty()) {
+            game.unmakeMove(tree.undo.back());
+            tree.undo.pop_back();
+        }
+    }
+}
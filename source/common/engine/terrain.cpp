@@ -1,6 +1,34 @@
 #include <engine/terrain.h>
+
+#include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 TerrainType::TerrainType(const std::string &id) : 
     ContentType(id)
-{}
\ No newline at end of file
+{}
+
+void TerrainType::StatTable::add(const TerrainType &type) {
+    if(type.numericID > UINT8_MAX)
+        throw std::length_error("Too many terrain types.");
+    assert(type.movementCost >= 0 && type.movementCost <= UINT16_MAX);
+    movementCost.push_back(static_cast<uint16_t>(type.movementCost));
+    maxMovementCost = std::max(maxMovementCost, type.movementCost);
+}
+
+Field<TerrainID> terrainIDField(const Field<const TerrainType *> &terrain) {
+    Field<TerrainID> result(terrain.size());
+    std::transform(terrain.begin(), terrain.end(), result.begin(), [](const TerrainType *type){
+        return static_cast<TerrainID>(type->numericID);
+    });
+    return result;
+}
+
+Field<uint16_t> movementCostField(const Field<TerrainID> &terrain) {
+    const auto &costs = TerrainType::registry.stats().movementCost;
+    Field<uint16_t> result(terrain.size());
+    std::transform(terrain.begin(), terrain.end(), result.begin(), [&](TerrainID id){
+        return costs[id];
+    });
+    return result;
+}
\ No newline at end of file
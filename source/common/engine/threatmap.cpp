@@ -0,0 +1,111 @@
+#include <engine/threatmap.h>
+
+#include <cassert>
+#include <cstdlib>
+
+#include <engine/game.h>
+
+ThreatMap::ThreatMap(int playerCount, glm::ivec2 mapSize) :
+    mapSize(mapSize),
+    playerCount(playerCount),
+    damageFields(playerCount * UnitType::registry.size(), Field<int>(mapSize, 0)),
+    attackerFields(playerCount, Field<int>(mapSize, 0)),
+    threatened(mapSize)
+{}
+
+const Field<int> &ThreatMap::damage(int player, const UnitType &target) const {
+    assert(player >= 0 && player < playerCount);
+    return damageFields[player * UnitType::registry.size() + target.numericID];
+}
+
+const Field<int> &ThreatMap::attackers(int player) const {
+    assert(player >= 0 && player < playerCount);
+    return attackerFields[player];
+}
+
+void ThreatMap::invalidate(const glm::ivec2 &tile) {
+    for(auto &contribution : contributions)
+        if(contribution.applied && contribution.dependencies.testOr(tile, false))
+            contribution.dirty = true;
+}
+
+void ThreatMap::update(const Game &game) {
+    const auto &pool = game.unitPool;
+    if(contributions.size() < pool.capacity())
+        contributions.resize(pool.capacity());
+
+    for(UnitHandle unit=0; unit<contributions.size(); ++unit) {
+        Contribution &contribution = contributions[unit];
+        bool present = pool.contains(unit);
+
+        // handles get reused, so also check that it's still the same unit in the same place
+        if(contribution.applied && (
+            contribution.dirty || !present ||
+            contribution.type != pool.type[unit] ||
+            contribution.player != pool.player[unit] ||
+            contribution.position != pool.position[unit]
+        )) {
+            apply(contribution, -1);
+            contribution.applied = false;
+        }
+        if(present && !contribution.applied) {
+            compute(game, unit, contribution);
+            apply(contribution, 1);
+            contribution.applied = true;
+        }
+        contribution.dirty = false;
+    }
+}
+
+void ThreatMap::apply(const Contribution &contribution, int sign) {
+    const auto &unitTypes = UnitType::registry;
+    const auto &stats = unitTypes.stats();
+    UnitTypeID attacker = contribution.type;
+
+    int *attackerCounts = attackerFields[contribution.player].data();
+    for(uint32_t tile : contribution.tiles)
+        attackerCounts[tile] += sign;
+
+    for(size_t target=0; target<unitTypes.size(); ++target) {
+        int damage = sign * stats.damage(attacker, static_cast<UnitTypeID>(target)) * stats.actionPointsPerTurn[attacker];
+        int *damagePerTile = damageFields[contribution.player * unitTypes.size() + target].data();
+        for(uint32_t tile : contribution.tiles)
+            damagePerTile[tile] += damage;
+    }
+}
+
+void ThreatMap::compute(const Game &game, UnitHandle unit, Contribution &outContribution) {
+    const auto &pool = game.unitPool;
+    const auto &stats = UnitType::registry.stats();
+    outContribution.type = pool.type[unit];
+    outContribution.player = pool.player[unit];
+    outContribution.position = pool.position[unit];
+
+    // next turn the unit will have all of its movement points again
+    auto reachable = scratch.findReachableTiles(game.movementCosts, game.occupancy(), outContribution.position, stats.movementPointsPerTurn[outContribution.type]);
+
+    if(outContribution.dependencies.size() != mapSize)
+        outContribution.dependencies = Bitboard(mapSize);
+    else
+        outContribution.dependencies.clear();
+    markDependencies(reachable, outContribution.dependencies);
+
+    threatened.clear();
+    int range = stats.attackRange[outContribution.type];
+    for(const auto &tile : reachable) {
+        // every tile within attack range (taxicab distance) of this one
+        for(int dy = -range; dy <= range; ++dy) {
+            int width = range - std::abs(dy);
+            for(int dx = -width; dx <= width; ++dx) {
+                glm::ivec2 target = tile.position + glm::ivec2(dx, dy);
+                if(threatened.inBounds(target))
+                    threatened.set(target);
+            }
+        }
+    }
+
+    outContribution.tiles.clear();
+    threatened.forEach([&](glm::ivec2 position){
+        outContribution.tiles.push_back(static_cast<uint32_t>(threatened.index(position)));
+    });
+}
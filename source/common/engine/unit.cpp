@@ -1,9 +1,39 @@
 #include <engine/unit.h>
 
+#include <cassert>
+#include <stdexcept>
+
 UnitType::UnitType(const std::string &id) :
     ContentType(id)
 {}
 
+int UnitType::StatTable::damage(UnitTypeID attacker, UnitTypeID target) const {
+    return damageMatrix[attacker * maxHealth.size() + target];
+}
+
+void UnitType::StatTable::add(const UnitType &type) {
+    if(type.numericID >= NO_UNIT_TYPE)
+        throw std::length_error("Too many unit types.");
+    maxHealth.push_back(type.maxHealth);
+    armor.push_back(type.armor);
+    evasion.push_back(type.evasion);
+    movementPointsPerTurn.push_back(type.movementPointsPerTurn);
+    actionPointsPerTurn.push_back(type.actionPointsPerTurn);
+    attackDamage.push_back(type.attackDamage);
+    attackPenetration.push_back(type.attackPenetration);
+    attackAccuracy.push_back(type.attackAccuracy);
+    attackRange.push_back(type.attackRange);
+
+    // the new type adds a row and a column, just rebuild the whole (tiny) matrix
+    const auto &types = UnitType::registry;
+    size_t count = maxHealth.size();
+    assert(types.size() == count);
+    damageMatrix.resize(count * count);
+    for(size_t attacker=0; attacker<count; ++attacker)
+        for(size_t target=0; target<count; ++target)
+            damageMatrix[attacker * count + target] = ::attackDamage(types[attacker], types[target]);
+}
+
 Unit::Unit() {}
 Unit::Unit(UnitType &type, int player, glm::ivec2 position) : 
     player(player),
@@ -18,20 +48,17 @@ bool Unit::isAlive() const {
     return health > 0;
 }
 
-void Unit::update(Game &game) {
-    actionPoints = type->actionPointsPerTurn;
-    movementPoints = type->movementPointsPerTurn;
-}
-
 void Unit::attack(Unit &other) {
     assert(actionPoints > 0);
 
-    int totalDamage = 
-        type->attackDamage * type->attackPenetration * type->attackAccuracy /
-        ((type->attackPenetration+other.type->armor) * (type->attackAccuracy+other.type->evasion));
-
     --actionPoints;
-    other.health = std::max(0, other.health-totalDamage);
+    other.health = std::max(0, other.health-attackDamage(*type, *other.type));
+}
+
+int attackDamage(const UnitType &attacker, const UnitType &target) {
+    return 
+        attacker.attackDamage * attacker.attackPenetration * attacker.attackAccuracy /
+        ((attacker.attackPenetration+target.armor) * (attacker.attackAccuracy+target.evasion));
 }
 
 RxBuffer &operator>>(RxBuffer &rx, Unit &unit) {
@@ -0,0 +1,80 @@
+#include <engine/unitpool.h>
+
+#include <cassert>
+#include <stdexcept>
+
+UnitHandle UnitPool::add(const Unit &unit) {
+    assert(unit.type != nullptr);
+    assert(unit.player >= 0 && unit.player <= UINT8_MAX);
+
+    UnitHandle handle;
+    if(!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        if(capacity() >= maxUnits)
+            throw std::length_error("Too many units.");
+        handle = static_cast<UnitHandle>(capacity());
+        type.emplace_back();
+        player.emplace_back();
+        health.emplace_back();
+        movementPoints.emplace_back();
+        actionPoints.emplace_back();
+        position.emplace_back();
+    }
+
+    type[handle] = static_cast<UnitTypeID>(unit.type->numericID);
+    player[handle] = static_cast<uint8_t>(unit.player);
+    health[handle] = unit.health;
+    movementPoints[handle] = unit.movementPoints;
+    actionPoints[handle] = unit.actionPoints;
+    position[handle] = unit.position;
+    return handle;
+}
+
+void UnitPool::remove(UnitHandle handle) {
+    assert(contains(handle));
+    type[handle] = NO_UNIT_TYPE;
+    freeHandles.push_back(handle);
+}
+
+void UnitPool::restore(UnitHandle handle, UnitTypeID unitType) {
+    assert(!freeHandles.empty() && freeHandles.back() == handle);
+    assert(unitType != NO_UNIT_TYPE);
+    freeHandles.pop_back();
+    type[handle] = unitType;
+}
+
+void UnitPool::clear() {
+    type.clear();
+    player.clear();
+    health.clear();
+    movementPoints.clear();
+    actionPoints.clear();
+    position.clear();
+    freeHandles.clear();
+}
+
+bool UnitPool::contains(UnitHandle handle) const {
+    return handle < capacity() && type[handle] != NO_UNIT_TYPE;
+}
+
+Unit UnitPool::get(UnitHandle handle) const {
+    assert(contains(handle));
+    Unit unit;
+    unit.type = &UnitType::registry[type[handle]];
+    unit.player = player[handle];
+    unit.health = health[handle];
+    unit.movementPoints = movementPoints[handle];
+    unit.actionPoints = actionPoints[handle];
+    unit.position = position[handle];
+    return unit;
+}
+
+size_t UnitPool::capacity() const {
+    return type.size();
+}
+
+size_t UnitPool::size() const {
+    return capacity() - freeHandles.size();
+}
@@ -0,0 +1,105 @@
+#include <network/byteorder.h>
+
+#include <cstring>
+#include <endian.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NF_X86_SIMD 1
+#endif
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+
+// Scalar fallback, also used for the tail of SIMD loops.
+// memcpy keeps unaligned accesses legal; the compiler turns it into plain loads & stores.
+template<typename T, T (*swap)(T)>
+static void convertScalar(uint8_t *bytes, size_t count) {
+    for(size_t i=0; i<count; ++i) {
+        T value;
+        memcpy(&value, bytes + i*sizeof(T), sizeof(T));
+        value = swap(value);
+        memcpy(bytes + i*sizeof(T), &value, sizeof(T));
+    }
+}
+
+static uint16_t swap16(uint16_t x) {return __builtin_bswap16(x);}
+static uint32_t swap32(uint32_t x) {return __builtin_bswap32(x);}
+static uint64_t swap64(uint64_t x) {return __builtin_bswap64(x);}
+
+#ifdef NF_X86_SIMD
+
+// pshufb masks reversing the bytes of every 2/4/8 byte lane within a 16 byte block
+static const uint8_t shuffleMasks[3][16] = {
+    {1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14},
+    {3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12},
+    {7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8}
+};
+
+__attribute__((target("avx2")))
+static size_t convertAvx2(uint8_t *bytes, size_t numBytes, const uint8_t *shuffleMask) {
+    __m128i mask128 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(shuffleMask));
+    __m256i mask = _mm256_broadcastsi128_si256(mask128);
+    size_t i = 0;
+    for(; i+32 <= numBytes; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes+i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(bytes+i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t convertSsse3(uint8_t *bytes, size_t numBytes, const uint8_t *shuffleMask) {
+    __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(shuffleMask));
+    size_t i = 0;
+    for(; i+16 <= numBytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes+i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(bytes+i), _mm_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+// __builtin_cpu_init() is required because this runs during static initialization
+static const bool hasAvx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+static const bool hasSsse3 = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+
+// @returns number of bytes converted with SIMD instructions (always a multiple of the value size)
+static size_t convertSimd(uint8_t *bytes, size_t numBytes, int maskIndex) {
+    if(hasAvx2)
+        return convertAvx2(bytes, numBytes, shuffleMasks[maskIndex]);
+    if(hasSsse3)
+        return convertSsse3(bytes, numBytes, shuffleMasks[maskIndex]);
+    return 0;
+}
+
+#else
+
+static size_t convertSimd(uint8_t *, size_t, int) {
+    return 0;
+}
+
+#endif
+
+void convertByteOrder16(void *data, size_t count) {
+    auto bytes = static_cast<uint8_t *>(data);
+    size_t done = convertSimd(bytes, count*2, 0);
+    convertScalar<uint16_t, swap16>(bytes+done, count - done/2);
+}
+void convertByteOrder32(void *data, size_t count) {
+    auto bytes = static_cast<uint8_t *>(data);
+    size_t done = convertSimd(bytes, count*4, 1);
+    convertScalar<uint32_t, swap32>(bytes+done, count - done/4);
+}
+void convertByteOrder64(void *data, size_t count) {
+    auto bytes = static_cast<uint8_t *>(data);
+    size_t done = convertSimd(bytes, count*8, 2);
+    convertScalar<uint64_t, swap64>(bytes+done, count - done/8);
+}
+
+#else
+
+// network byte order == host byte order
+void convertByteOrder16(void *, size_t) {}
+void convertByteOrder32(void *, size_t) {}
+void convertByteOrder64(void *, size_t) {}
+
+#endif
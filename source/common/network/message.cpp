@@ -1,13 +1,22 @@
 #include <network/message.h>
+#include <network/exceptions.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <system_error>
 
+#include <endian.h>
+
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 typedef uint32_t msg_size_t;
 
+// upper limit for the number of output segments sent by one sendmsg() call (well below IOV_MAX)
+static constexpr size_t maxSentSegments = 64;
+
 MessageSocket::MessageSocket(int sockfd) :
     sockfd(sockfd)
 {}
@@ -17,58 +26,146 @@ MessageSocket::~MessageSocket() {
         perror("Failed to close socket");
 }
 void MessageSocket::update() {
-    if(!connected) 
+    if(!connected || !directIO) 
         return;
 
-    // Attempt to receive data
-    uint8_t buffer[1024];
-    ssize_t numReceivedBytes = recv(sockfd, buffer, sizeof buffer, MSG_DONTWAIT);
-    switch(numReceivedBytes) {
-
-        case -1:
+    // Attempt to receive data straight into the receive buffer. Keep reading until the 
+    // socket is drained, so that readiness-based callers (epoll) don't have to come back for the rest.
+    while(rxBuffer.writableSize() > 0) {
+        size_t maxBytes = rxBuffer.writableSize();
+        ssize_t numReceivedBytes = recv(sockfd, rxBuffer.writePtr(), maxBytes, MSG_DONTWAIT);
+        if(numReceivedBytes == -1) {
+            if(errno == EINTR)
+                continue;
             if(errno != EAGAIN && errno != EWOULDBLOCK)
                 throw std::system_error(errno, std::generic_category(), "recv failed");
             break;
-        break;
-
-        case 0:
+        } else if(numReceivedBytes == 0) {
             // other side disconnected -> stop all socket operations
             connected = false;
             return;
-
-        default:
-            rxBuffer.pushNetworkOrder(buffer, static_cast<size_t>(numReceivedBytes));
+        }
+        rxBuffer.commit(static_cast<size_t>(numReceivedBytes));
+        if(static_cast<size_t>(numReceivedBytes) < maxBytes)
             break;
     }
 
-        // Attempt to send data
-    if(txBuffer.size() > 0) {
-        ssize_t numSentBytes = send(sockfd, txBuffer.ptr(), static_cast<ssize_t>(txBuffer.size()), MSG_DONTWAIT|MSG_NOSIGNAL);
-        if(numSentBytes > 0) {
-            txBuffer.pop(static_cast<size_t>(numSentBytes));
-            txBuffer.maybeCompact();
-        } else if(numSentBytes == -1)
+    flush();
+}
+void MessageSocket::flush() {
+    if(!connected || !directIO) 
+        return;
+
+    while(!output.empty()) {
+        // everything queued goes out with one syscall, frames are sent straight from their shared storage
+        iovec parts[maxSentSegments];
+        msghdr message = {};
+        message.msg_iov = parts;
+        const uint8_t *buffered = txBuffer.ptr();
+        for(const auto &segment : output) {
+            if(message.msg_iovlen == maxSentSegments)
+                break;
+            if(segment.frame) {
+                parts[message.msg_iovlen].iov_base = const_cast<uint8_t *>(segment.frame->ptr() + segment.offset);
+            } else {
+                parts[message.msg_iovlen].iov_base = const_cast<uint8_t *>(buffered);
+                buffered += segment.size;
+            }
+            parts[message.msg_iovlen].iov_len = segment.size;
+            ++message.msg_iovlen;
+        }
+
+        ssize_t numSentBytes = sendmsg(sockfd, &message, MSG_DONTWAIT|MSG_NOSIGNAL);
+        if(numSentBytes > 0)
+            onSent(static_cast<size_t>(numSentBytes));
+        else if(numSentBytes == -1)
             switch(errno) {
 
-                case EAGAIN: 
+                case EINTR:
                     break;
 
+                case EAGAIN: 
+                    return;
+
                 case EPIPE: 
+                case ECONNRESET:
                     connected = false; 
                     return;
 
                 default:
-                    throw std::system_error(errno, std::generic_category(), "send failed");
+                    throw std::system_error(errno, std::generic_category(), "sendmsg failed");
             }
     }
 }
 bool MessageSocket::isConnected() const {
     return connected;
 }
+int MessageSocket::fd() const {
+    return sockfd;
+}
+bool MessageSocket::hasPendingOutput() const {
+    return connected && outputSize > 0;
+}
+void MessageSocket::setDirectIO(bool enabled) {
+    directIO = enabled;
+}
+void MessageSocket::onReceived(const void *data, size_t numBytes) {
+    rxBuffer.push(data, numBytes);
+}
+size_t MessageSocket::receiveCapacity() const {
+    return rxBuffer.writableSize();
+}
+size_t MessageSocket::pendingOutputSize() const {
+    return outputSize;
+}
+size_t MessageSocket::copyPendingOutput(uint8_t *dst, size_t maxBytes) const {
+    size_t copied = 0;
+    const uint8_t *buffered = txBuffer.ptr();
+    for(const auto &segment : output) {
+        if(copied == maxBytes)
+            break;
+        size_t numBytes = std::min(segment.size, maxBytes - copied);
+        memcpy(dst + copied, segment.frame ? segment.frame->ptr() + segment.offset : buffered, numBytes);
+        if(!segment.frame)
+            buffered += segment.size;
+        copied += numBytes;
+    }
+    return copied;
+}
+void MessageSocket::onSent(size_t numBytes) {
+    assert(numBytes <= outputSize);
+    outputSize -= numBytes;
+    while(numBytes > 0) {
+        OutputSegment &segment = output.front();
+        size_t sent = std::min(numBytes, segment.size);
+        if(segment.frame)
+            segment.offset += sent;
+        else
+            txBuffer.pop(sent);
+        segment.size -= sent;
+        numBytes -= sent;
+        // releases the frame once it has been sent
+        if(segment.size == 0)
+            output.pop_front();
+    }
+    txBuffer.maybeCompact();
+}
+void MessageSocket::onRemoteClosed() {
+    connected = false;
+}
+// reads the size prefix of the first message in the receive buffer
+static size_t peekMessageSize(const RingBuffer &rxBuffer) {
+    msg_size_t messageSize;
+    memcpy(&messageSize, rxBuffer.ptr(), sizeof messageSize);
+    return be32toh(messageSize);
+}
+
 bool MessageSocket::hasMessage() {
     if(rxBuffer.size() < sizeof(msg_size_t))
         return false;
-    size_t messageSize = rxBuffer.peek<msg_size_t>();
+    size_t messageSize = peekMessageSize(rxBuffer);
+    if(sizeof(msg_size_t) + messageSize > rxBuffer.capacity())
+        throw ProtocolError("Message too long.");
     return rxBuffer.size() >= sizeof(msg_size_t) + messageSize;
 }
 RxBuffer MessageSocket::receiveMessage() {
@@ -79,10 +176,11 @@ RxBuffer MessageSocket::receiveMessage() {
 
     assert(hasMessage());
 
-    RxBuffer result;
+    size_t messageSize = peekMessageSize(rxBuffer);
+    RxBuffer result(rxBuffer.ptr()+sizeof(msg_size_t), messageSize);
 
-    size_t messageSize = rxBuffer.peek<msg_size_t>();
-    result.pushNetworkOrder(rxBuffer.ptr()+sizeof(msg_size_t), messageSize);
+    // the bytes stay where they are until update() receives new data,
+    // so the view remains valid after popping
     rxBuffer.pop(sizeof(msg_size_t)+messageSize);
 
     return result;
@@ -92,6 +190,49 @@ void MessageSocket::sendMessage(const TxBuffer &message) {
         return;
     txBuffer << static_cast<msg_size_t>(message.size());
     txBuffer.pushNetworkOrder(message.ptr(), message.size());
+    queueBuffered(sizeof(msg_size_t) + message.size());
+}
+TxBuffer &MessageSocket::beginMessage() {
+    assert(!buildingMessage);
+
+    // reserve space for the size prefix, it's filled in by endMessage()
+    messageStart = txBuffer.size();
+    buildingMessage = true;
+    txBuffer << static_cast<msg_size_t>(0);
+    return txBuffer;
+}
+void MessageSocket::endMessage() {
+    assert(buildingMessage);
+    buildingMessage = false;
+
+    if(!connected) {
+        txBuffer.truncate(messageStart);
+        return;
+    }
+
+    msg_size_t messageSize = htobe32(static_cast<msg_size_t>(txBuffer.size() - messageStart - sizeof(msg_size_t)));
+    txBuffer.overwriteNetworkOrder(messageStart, &messageSize, sizeof messageSize);
+    queueBuffered(txBuffer.size() - messageStart);
+}
+void MessageSocket::queueBuffered(size_t numBytes) {
+    if(!output.empty() && !output.back().frame)
+        output.back().size += numBytes;
+    else
+        output.push_back({nullptr, 0, numBytes});
+    outputSize += numBytes;
+}
+
+void MessageSocket::patchFrameSize(TxBuffer &frame) {
+    msg_size_t messageSize = htobe32(static_cast<msg_size_t>(frame.size() - sizeof(msg_size_t)));
+    frame.overwriteNetworkOrder(0, &messageSize, sizeof messageSize);
+}
+void MessageSocket::sendFrame(SharedFrame frame) {
+    if(!connected || frame->size() == 0)
+        return;
+    // the frame already contains the size prefix
+    size_t size = frame->size();
+    output.push_back({std::move(frame), 0, size});
+    outputSize += size;
 }
 
 void MessageSocket::waitForMessage(const Duration &timeout) {
@@ -8,6 +8,21 @@ void NetworkBuffer::pushNetworkOrder(const void *ptr, size_t numBytes) {
     auto bytePtr = static_cast<const uint8_t *>(ptr);
     store.insert(store.end(), bytePtr, bytePtr+numBytes);
 }
+uint8_t *NetworkBuffer::grow(size_t numBytes) {
+    size_t oldSize = store.size();
+    store.resize(oldSize + numBytes);
+    return &store[oldSize];
+}
+void NetworkBuffer::overwriteNetworkOrder(size_t offset, const void *ptr, size_t numBytes) {
+    if(offset + numBytes > size())
+        throw std::out_of_range("Attempting to overwrite bytes beyond buffer bounds.");
+    memcpy(&store[position + offset], ptr, numBytes);
+}
+void NetworkBuffer::truncate(size_t numBytes) {
+    if(numBytes > size())
+        throw std::out_of_range("Attempting to truncate buffer to a larger size.");
+    store.resize(position + numBytes);
+}
 const uint8_t *NetworkBuffer::ptr() const {
     return &store[0] + position;
 }
@@ -20,12 +35,15 @@ void NetworkBuffer::pop(size_t numBytes) {
     position += numBytes;
 }
 void NetworkBuffer::maybeCompact() {
-    if(store.size() >= 2*size())
+    if(size() == 0) {
+        // common case: everything was consumed, keep the allocation for the next message
+        store.clear();
+        position = 0;
+    } else if(position >= size())
         compact();
 }
 void NetworkBuffer::compact() {
     store.erase(store.begin(), store.begin()+position);
-    store.shrink_to_fit();
     position = 0;
 }
 
@@ -5,9 +5,7 @@
 
 bool performVersionHandshake(MessageSocket &s, const Duration &timeout) {
 
-    TxBuffer request;
-    request << MessageType::VERSION << applicationVersion;
-    s.sendMessage(request);
+    s.send(MessageType::VERSION, applicationVersion);
     s.waitForMessage(timeout);
 
     RxBuffer response = s.receiveMessage();
@@ -106,60 +104,77 @@ void NFProtocolEntity::runNetworkEvents() {
     if(!msock.isConnected())
         onDisconnect();
 
-    if(!msock.hasMessage() && _timeoutActive && Clock::now() >= timeoutDeadline)
-        onTimeout();
+    try {
+        if(!msock.hasMessage() && _timeoutActive && Clock::now() >= timeoutDeadline)
+            onTimeout();
 
-    while(msock.hasMessage() && isRunning()) {
-        RxBuffer message = msock.receiveMessage();
-        try {
-            MessageType type = message.read<MessageType>();
+        while(isRunning() && msock.hasMessage()) {
+            RxBuffer message = msock.receiveMessage();
+            try {
+                MessageType type = message.read<MessageType>();
             
-            if(!blacklist.empty() && blacklist.find(type) != blacklist.end())
-                throw ProtocolError("Blacklisted message type received.");
-
-            if(!whitelist.empty() && whitelist.find(type) == whitelist.end())
-                throw ProtocolError("Message type not whitelisted.");
-
-            switch(type) {
-
-                #define DISPATCH(typetag, type, method) \
-                case MessageType::typetag: { \
-                    auto value = message.read<type>(); \
-                    if(message.size() > 0) \
-                        throw ProtocolError("Message too long!"); \
-                    method(value); \
-                    break; \
+                if(!blacklist.empty() && blacklist.find(type) != blacklist.end())
+                    throw ProtocolError("Blacklisted message type received.");
+
+                if(!whitelist.empty() && whitelist.find(type) == whitelist.end())
+                    throw ProtocolError("Message type not whitelisted.");
+
+                switch(type) {
+
+                    #define DISPATCH(typetag, type, method) \
+                    case MessageType::typetag: { \
+                        auto value = message.read<type>(); \
+                        if(message.size() > 0) \
+                            throw ProtocolError("Message too long!"); \
+                        method(value); \
+                        break; \
+                    }
+
+                    DISPATCH(VERSION,               Version,                onVersionHandshake)
+                    DISPATCH(LOGIN_REQUEST,         LoginRequest,           onLoginRequest)
+                    DISPATCH(LOGIN_RESPONSE,        LoginResponse,          onLoginResponse)
+                    DISPATCH(ECHO,                  EchoRequest,            onEchoRequest)
+                    DISPATCH(ALERT,                 AlertRequest,           onAlertRequest)
+                    DISPATCH(HOST_GAME,             HostGameRequest,        onHostGameRequest)
+                    DISPATCH(HOST_GAME_ACK,         HostGameAck,            onHostGameAck)
+                    DISPATCH(JOIN_GAME,             JoinGameRequest,        onJoinGameRequest)
+                    DISPATCH(LEAVE_GAME,            LeaveGameRequest,       onLeaveGameRequest)
+                    DISPATCH(GAME_JOIN_ERROR,       GameJoinError,          onGameJoinError)
+                    DISPATCH(GAME_FULL_SYNC,        Game,                   onFullSync)
+                    DISPATCH(GAME_INCREMENTAL_SYNC, GameIncrementalSync,    onIncrementalSync)
+
+                    #undef DISPATCH
+
+                    default:
+                        throw ProtocolError("Unknown message type.");
                 }
 
-                DISPATCH(VERSION,               Version,                onVersionHandshake)
-                DISPATCH(LOGIN_REQUEST,         LoginRequest,           onLoginRequest)
-                DISPATCH(LOGIN_RESPONSE,        LoginResponse,          onLoginResponse)
-                DISPATCH(ECHO,                  EchoRequest,            onEchoRequest)
-                DISPATCH(ALERT,                 AlertRequest,           onAlertRequest)
-                DISPATCH(HOST_GAME,             HostGameRequest,        onHostGameRequest)
-                DISPATCH(HOST_GAME_ACK,         HostGameAck,            onHostGameAck)
-                DISPATCH(JOIN_GAME,             JoinGameRequest,        onJoinGameRequest)
-                DISPATCH(LEAVE_GAME,            LeaveGameRequest,       onLeaveGameRequest)
-                DISPATCH(GAME_JOIN_ERROR,       GameJoinError,          onGameJoinError)
-                DISPATCH(GAME_FULL_SYNC,        Game,                   onFullSync)
-                DISPATCH(GAME_INCREMENTAL_SYNC, GameIncrementalSync,    onIncrementalSync)
-
-                #undef DISPATCH
-
-                default:
-                    throw ProtocolError("Unknown message type.");
-            }
-
-            _timeoutActive = false;
+                _timeoutActive = false;
 
-        } catch (const ProtocolError &e) {
-            onProtocolError(e);
-        } catch (const std::out_of_range &) {
-            onProtocolError(ProtocolError("Message too short."));
+            } catch (const ProtocolError &e) {
+                onProtocolError(e);
+            } catch (const std::out_of_range &) {
+                onProtocolError(ProtocolError("Message too short."));
+            }
         }
+    } catch (const ProtocolError &e) {
+        // thrown by hasMessage() if the peer announced a message which can never fit in the receive buffer
+        onProtocolError(e);
     }
 }
 
+void NFProtocolEntity::flushNetworkEvents() {
+    msock.flush();
+}
+
+const MessageSocket &NFProtocolEntity::socket() const {
+    return msock;
+}
+
+MessageSocket &NFProtocolEntity::socket() {
+    return msock;
+}
+
 void NFProtocolEntity::halt() {
     _running = false;
 }
@@ -174,64 +189,49 @@ void NFProtocolEntity::setTimeout(const Duration &d) {
 }
 
 void NFProtocolEntity::sendVersionHandshake(const Version &v) {
-    TxBuffer message;
-    message << MessageType::VERSION << v;
-    msock.sendMessage(message);
+    msock.send(MessageType::VERSION, v);
 }
 void NFProtocolEntity::sendLoginRequest(const LoginRequest &r) {
-    TxBuffer message;
-    message << MessageType::LOGIN_REQUEST << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::LOGIN_REQUEST, r);
 }
 void NFProtocolEntity::sendLoginResponse(LoginResponse r) {
-    TxBuffer message;
-    message << MessageType::LOGIN_RESPONSE << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::LOGIN_RESPONSE, r);
 }
 void NFProtocolEntity::sendEchoRequest(const EchoRequest &r) {
-    TxBuffer message;
-    message << MessageType::ECHO << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::ECHO, r);
 }
 void NFProtocolEntity::sendAlertRequest(const AlertRequest &r) {
-    TxBuffer message;
-    message << MessageType::ALERT << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::ALERT, r);
 }
 void NFProtocolEntity::sendHostGameRequest(const HostGameRequest &r) {
-    TxBuffer message;
-    message << MessageType::HOST_GAME << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::HOST_GAME, r);
 }
 void NFProtocolEntity::sendHostGameAck(const HostGameAck &r) {
-    TxBuffer message;
-    message << MessageType::HOST_GAME_ACK << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::HOST_GAME_ACK, r);
 }
 void NFProtocolEntity::sendJoinGameRequest(const JoinGameRequest &r) {
-    TxBuffer message;
-    message << MessageType::JOIN_GAME << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::JOIN_GAME, r);
 }
 void NFProtocolEntity::sendLeaveGameRequest(const LeaveGameRequest &r) {
-    TxBuffer message;
-    message << MessageType::LEAVE_GAME << r;
-    msock.sendMessage(message);
+    msock.send(MessageType::LEAVE_GAME, r);
 }
 void NFProtocolEntity::sendFullSync(const Game &s) {
-    TxBuffer message;
-    message << MessageType::GAME_FULL_SYNC << s;
-    msock.sendMessage(message);
+    msock.send(MessageType::GAME_FULL_SYNC, s);
 }
 void NFProtocolEntity::sendIncrementalSync(const GameIncrementalSync &s) {
-    TxBuffer message;
-    message << MessageType::GAME_INCREMENTAL_SYNC << s;
-    msock.sendMessage(message);
+    msock.send(MessageType::GAME_INCREMENTAL_SYNC, s);
+}
+SharedFrame NFProtocolEntity::encodeIncrementalSync(const GameIncrementalSync &s) {
+    return MessageSocket::encodeFrame(MessageType::GAME_INCREMENTAL_SYNC, s);
+}
+SharedFrame NFProtocolEntity::encodeFullSync(const Game &s) {
+    return MessageSocket::encodeFrame(MessageType::GAME_FULL_SYNC, s);
+}
+void NFProtocolEntity::sendFrame(const SharedFrame &frame) {
+    msock.sendFrame(frame);
 }
 void NFProtocolEntity::sendGameJoinError(GameJoinError error) {
-    TxBuffer message;
-    message << MessageType::GAME_JOIN_ERROR << error;
-    msock.sendMessage(message);
+    msock.send(MessageType::GAME_JOIN_ERROR, error);
 }
 void NFProtocolEntity::onInit() {
     whitelist = {MessageType::VERSION};
@@ -0,0 +1,117 @@
+#include <network/ringbuffer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Maps the same memory file twice, back to back.
+// @returns nullptr on failure.
+static uint8_t *createMirroredMapping(size_t capacity) {
+
+    int fd = memfd_create("nightfleet-ringbuffer", MFD_CLOEXEC);
+    if(fd == -1)
+        return nullptr;
+
+    if(ftruncate(fd, static_cast<off_t>(capacity)) == -1) {
+        close(fd);
+        return nullptr;
+    }
+
+    // reserve address space for both copies first, so that nothing else can end up in between
+    void *reserved = mmap(nullptr, 2*capacity, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(reserved == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    auto base = static_cast<uint8_t *>(reserved);
+
+    bool ok = 
+        mmap(base, capacity, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED &&
+        mmap(base+capacity, capacity, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED;
+
+    // the mappings keep the memory file alive
+    close(fd);
+
+    if(!ok) {
+        munmap(base, 2*capacity);
+        return nullptr;
+    }
+    return base;
+}
+
+RingBuffer::RingBuffer(size_t minCapacity) {
+
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    _capacity = (std::max<size_t>(minCapacity, 1) + pageSize - 1) / pageSize * pageSize;
+
+    base = createMirroredMapping(_capacity);
+    mirrored = base != nullptr;
+
+    if(!mirrored) {
+        base = static_cast<uint8_t *>(malloc(_capacity));
+        if(base == nullptr)
+            throw std::bad_alloc();
+    }
+}
+
+RingBuffer::~RingBuffer() {
+    if(mirrored)
+        munmap(base, 2*_capacity);
+    else
+        free(base);
+}
+
+size_t RingBuffer::capacity() const {
+    return _capacity;
+}
+
+size_t RingBuffer::size() const {
+    return tail - head;
+}
+
+const uint8_t *RingBuffer::ptr() const {
+    return mirrored ? base + head % _capacity : base + head;
+}
+
+void RingBuffer::pop(size_t numBytes) {
+    if(numBytes > size())
+        throw std::out_of_range("Attempting to pop more bytes from buffer than available.");
+    head += numBytes;
+    if(!mirrored && head == tail)
+        head = tail = 0;
+}
+
+size_t RingBuffer::writableSize() const {
+    return _capacity - size();
+}
+
+uint8_t *RingBuffer::writePtr() {
+    if(mirrored)
+        return base + tail % _capacity;
+
+    // make all free space contiguous
+    if(head > 0) {
+        memmove(base, base+head, size());
+        tail -= head;
+        head = 0;
+    }
+    return base + tail;
+}
+
+void RingBuffer::commit(size_t numBytes) {
+    assert(numBytes <= writableSize());
+    tail += numBytes;
+}
+
+void RingBuffer::push(const void *data, size_t numBytes) {
+    if(numBytes > writableSize())
+        throw std::length_error("Not enough space in ring buffer.");
+    memcpy(writePtr(), data, numBytes);
+    commit(numBytes);
+}
@@ -4,6 +4,35 @@
 #include <endian.h>
 #include <stdexcept>
 
+RxBuffer::RxBuffer() : 
+    data(nullptr), 
+    dataSize(0)
+{}
+RxBuffer::RxBuffer(const uint8_t *data, size_t numBytes) :
+    data(data),
+    dataSize(numBytes)
+{}
+
+const uint8_t *RxBuffer::ptr() const {
+    return data + position;
+}
+size_t RxBuffer::size() const {
+    return dataSize - position;
+}
+void RxBuffer::pop(size_t numBytes) {
+    if(numBytes > size())
+        throw std::out_of_range("Attempting to pop more bytes from buffer than available.");
+    position += numBytes;
+}
+size_t RxBuffer::getPosition() const {
+    return position;
+}
+void RxBuffer::setPosition(size_t newPosition) {
+    if(newPosition > dataSize)
+        throw std::out_of_range("Attempting to setPosition beyond buffer bounds.");
+    position = newPosition;
+}
+
 // For unsigned types: memcpy and byteswap if necessary
 // also check bounds on every read to prevent exploits
 
@@ -63,9 +92,9 @@ RxBuffer &operator>>(RxBuffer &rx, double &result) {
 // Strings are length-prefixed; chars stored as uint8_t (assume ASCII/UTF-8)
 RxBuffer &operator>>(RxBuffer &rx, std::string &result) {
     auto stringLength = rx.read<uint32_t>();
-    result.clear();
-    result.reserve(stringLength);
-    for(uint32_t i=0; i<stringLength; ++i)
-        result += static_cast<char>(rx.read<uint8_t>());
+    if(rx.size() < stringLength)
+        throw std::out_of_range("");
+    result.assign(reinterpret_cast<const char *>(rx.ptr()), stringLength);
+    rx.pop(stringLength);
     return rx;
 }
\ No newline at end of file
@@ -44,7 +44,6 @@ TxBuffer &operator<<(TxBuffer &tx, double value) {
 
 TxBuffer &operator<<(TxBuffer &tx, const std::string &value) {
     tx << static_cast<uint32_t>(value.size());
-    for(char character : value)
-        tx << static_cast<uint8_t>(character);
+    tx.pushNetworkOrder(value.data(), value.size());
     return tx;
 }
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include <util/scheduler.h>
+
+#include <iostream>
+#include <utility>
+
+#include <pthread.h>
+#include <sched.h>
+
+// lets worker threads find their own deque
+static thread_local const Scheduler *currentScheduler = nullptr;
+static thread_local size_t currentIndex = 0;
+
+Scheduler::Scheduler(int threadCount, bool pinThreads) {
+    int coreCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if(threadCount <= 0)
+        threadCount = coreCount;
+
+    for(int i=0; i<threadCount; ++i)
+        workers.push_back(std::make_unique<Worker>());
+
+    // all workers have to exist before any of them starts stealing
+    for(int i=0; i<threadCount; ++i) {
+        workers[i]->thread = std::thread(&Scheduler::run, this, i);
+        if(pinThreads) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % coreCount, &cpus);
+            if(pthread_setaffinity_np(workers[i]->thread.native_handle(), sizeof cpus, &cpus) != 0)
+                std::cerr << "Failed to pin scheduler worker " << i << " to a core" << std::endl;
+        }
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::scoped_lock lk(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for(auto &worker : workers)
+        worker->thread.join();
+}
+
+void Scheduler::spawn(Task task) {
+    size_t index = currentWorkerIndex();
+    if(index == workers.size())
+        index = nextWorker++ % workers.size();
+    // counted before it's visible, so that the counter can't underflow when it's stolen right away
+    ++queuedTasks;
+    {
+        std::scoped_lock lk(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+
+    // a worker about to sleep increments sleepingWorkers before checking queuedTasks,
+    // so either it sees the new task or we see it and wake it up
+    if(sleepingWorkers > 0) {
+        { std::scoped_lock lk(sleepMutex); }
+        wakeCondition.notify_one();
+    }
+}
+
+bool Scheduler::runPendingTask() {
+    if(queuedTasks == 0)
+        return false;
+
+    size_t index = currentWorkerIndex();
+    Task task;
+    if(!popTask(index == workers.size() ? 0 : index, task))
+        return false;
+    task();
+    return true;
+}
+
+int Scheduler::threadCount() const {
+    return static_cast<int>(workers.size());
+}
+
+void Scheduler::run(size_t index) {
+    currentScheduler = this;
+    currentIndex = index;
+
+    while(true) {
+        Task task;
+        if(popTask(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock lk(sleepMutex);
+        ++sleepingWorkers;
+        wakeCondition.wait(lk, [this]{ return stopping || queuedTasks > 0; });
+        --sleepingWorkers;
+        if(stopping && queuedTasks == 0)
+            return;
+    }
+}
+
+bool Scheduler::popTask(size_t firstVictim, Task &outTask) {
+    // own tasks are taken from the back...
+    if(firstVictim == currentWorkerIndex()) {
+        Worker &worker = *workers[firstVictim];
+        std::scoped_lock lk(worker.mutex);
+        if(!worker.tasks.empty()) {
+            outTask = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            --queuedTasks;
+            return true;
+        }
+    }
+    // ...and stolen ones from the front
+    for(size_t i=0; i<workers.size(); ++i) {
+        Worker &victim = *workers[(firstVictim + i) % workers.size()];
+        std::scoped_lock lk(victim.mutex);
+        if(!victim.tasks.empty()) {
+            outTask = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queuedTasks;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Scheduler::currentWorkerIndex() const {
+    return currentScheduler == this ? currentIndex : workers.size();
+}
+
+TaskGroup::TaskGroup(Scheduler &scheduler) :
+    scheduler(scheduler),
+    state(std::make_shared<State>())
+{}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch(...) {}
+}
+
+void TaskGroup::run(Scheduler::Task task) {
+    {
+        std::scoped_lock lk(state->mutex);
+        state->tasks.push_back(std::move(task));
+        ++state->pendingTasks;
+    }
+    // wakes up wait() if it's blocked, so that it can help
+    state->changed.notify_all();
+    scheduler.spawn([state = state]{
+        runQueuedTask(*state, false);
+    });
+}
+
+void TaskGroup::wait() {
+    for(;;) {
+        // the newest task first, it's the most likely to still be in the cache
+        if(runQueuedTask(*state, true))
+            continue;
+        // the remaining tasks are running on other threads, but they may still add new ones
+        std::unique_lock lk(state->mutex);
+        state->changed.wait(lk, [this]{ return state->pendingTasks == 0 || !state->tasks.empty(); });
+        if(state->pendingTasks == 0)
+            break;
+    }
+
+    std::exception_ptr rethrown;
+    {
+        std::scoped_lock lk(state->mutex);
+        rethrown = std::exchange(state->error, nullptr);
+    }
+    if(rethrown)
+        std::rethrow_exception(rethrown);
+}
+
+bool TaskGroup::runQueuedTask(State &state, bool newest) {
+    Scheduler::Task task;
+    {
+        std::scoped_lock lk(state.mutex);
+        if(state.tasks.empty())
+            return false;
+        if(newest) {
+            task = std::move(state.tasks.back());
+            state.tasks.pop_back();
+        } else {
+            task = std::move(state.tasks.front());
+            state.tasks.pop_front();
+        }
+    }
+
+    std::exception_ptr error;
+    try {
+        task();
+    } catch(...) {
+        error = std::current_exception();
+    }
+
+    bool finished;
+    {
+        std::scoped_lock lk(state.mutex);
+        if(error && !state.error)
+            state.error = error;
+        finished = --state.pendingTasks == 0;
+    }
+    if(finished)
+        state.changed.notify_all();
+    return true;
+}
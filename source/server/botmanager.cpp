@@ -0,0 +1,144 @@
+#include <botmanager.h>
+
+#include <cassert>
+#include <iostream>
+
+BotManager::BotManager(UserManager &users, GameManager &games) :
+    users(users),
+    games(games)
+{}
+
+BotManager::~BotManager() {
+    if(!scheduler)
+        return;
+    stopping = true;
+    thinking->wait();
+    thinking.reset();
+    scheduler.reset();
+
+    // bots reference their games (through the listeners) and vice versa until they leave
+    std::vector<std::shared_ptr<Bot>> remaining;
+    {
+        std::scoped_lock lk(mutex);
+        for(auto &[username, bot] : bots)
+            remaining.push_back(bot);
+    }
+    for(auto &bot : remaining)
+        leave(*bot);
+}
+
+void BotManager::configure(const BotConfig &config) {
+    assert(!scheduler);
+    _config = config;
+    scheduler = std::make_unique<Scheduler>(config.threadCount);
+    thinking = std::make_unique<TaskGroup>(*scheduler);
+}
+
+const BotConfig &BotManager::config() const {
+    return _config;
+}
+
+void BotManager::fillGame(GameID id) {
+    if(!scheduler)
+        return;
+
+    for(;;) {
+        GameHandle game = games.getGame(id);
+        if(!game || game.isReady())
+            return;
+
+        auto bot = std::make_shared<Bot>();
+        // reserve a username nobody is logged in as
+        do bot->username = "bot-" + std::to_string(nextBotID++);
+        while(users.tryLogin({bot->username}) != LoginResponse::OK);
+        bot->game = game;
+        bot->seed = static_cast<uint64_t>(id) ^ std::hash<std::string>()(bot->username);
+        {
+            std::scoped_lock lk(mutex);
+            bots[bot->username] = bot;
+        }
+
+        // the listener may already run before joinGame() returns, so the bot has its handle from getGame()
+        GameHandle joined;
+        auto error = games.joinGame(bot->username, id, joined, [this, bot]{ schedule(bot); });
+        if(error != GameJoinError::NO_ERROR) {
+            {
+                std::scoped_lock lk(mutex);
+                bots.erase(bot->username);
+            }
+            users.logout(bot->username);
+            return;
+        }
+        std::cerr << bot->username << " joined game " << id << std::endl;
+    }
+}
+
+void BotManager::schedule(const std::shared_ptr<Bot> &bot) {
+    if(!stopping && !bot->scheduled.exchange(true))
+        thinking->run([this, bot]{ think(bot); });
+}
+
+void BotManager::think(const std::shared_ptr<Bot> &bot) {
+    Game snapshot;
+    bool done = false;
+    {
+        std::scoped_lock lk(bot->game.mutex());
+        // changes from now on need another look
+        bot->scheduled = false;
+        if(bot->left)
+            return;
+
+        Game &game = bot->game.game();
+        if(game.didPlayerWin(bot->username) || game.didPlayerLoose(bot->username) || !hasPeople(bot->game.players()))
+            done = true;
+        else if(game.currentPlayer() != bot->username)
+            return;
+        else
+            // only the state is needed, the search builds its own caches
+            snapshot = game.stateCopy();
+    }
+    if(done) {
+        leave(*bot);
+        return;
+    }
+
+    // the game stays unlocked while searching, so that the other players' connections aren't blocked
+    SearchEngine engine(*scheduler);
+    Move move = engine.findMove(snapshot, _config.limits, bot->seed++);
+    {
+        std::scoped_lock lk(bot->game.mutex());
+        Game &game = bot->game.game();
+        // someone left or surrendered in the meantime, the move may not make sense anymore
+        if(bot->left || game.version() != snapshot.version()) {
+            schedule(bot);
+            return;
+        }
+        MoveStatus status = game.tryMakeMove(move);
+        if(status != MoveStatus::OK) {
+            // never happens unless the search has a bug, ending the turn at least keeps the game going
+            std::cerr << bot->username << " made an invalid move: " << moveStatusMessage(status) << std::endl;
+            move = Move::endTurn();
+            game.makeMove(move);
+        }
+        bot->game.journal().publish(bot->username, {move});
+    }
+    // keep going until the turn is over
+    schedule(bot);
+}
+
+void BotManager::leave(Bot &bot) {
+    if(bot.left.exchange(true))
+        return;
+    games.leaveGame(bot.username);
+    users.logout(bot.username);
+    std::scoped_lock lk(mutex);
+    bots.erase(bot.username);
+}
+
+bool BotManager::hasPeople(const std::vector<std::string> &players) {
+    std::scoped_lock lk(mutex);
+    for(const auto &player : players)
+        if(bots.find(player) == bots.end())
+            return true;
+    return false;
+}
@@ -7,7 +7,6 @@
 #include <network/txbuffer.h>
 #include <network/protocol.h>
 #include <util/time.h>
-#include <scope_guard.h>
 
 class NFServerProtocolEntity : public NFProtocolEntity {
     private:
@@ -21,16 +20,21 @@ class NFServerProtocolEntity : public NFProtocolEntity {
     } fsm = DISCONNECTED;
 
     Server &server;
+    GameListener gameListener;
     std::string username;
-    GameID gameID = 0;
-    size_t knownMoveCount;
+    GameHandle game;
+    size_t knownBatchCount;
+    // set while waiting for a random opponent, bots take the free seats if nobody comes in time
+    bool waitingForOpponent = false;
+    TimePoint waitingSince;
 
     public:
     std::string haltReason;
 
-    NFServerProtocolEntity(int sockfd, Server &server) : 
+    NFServerProtocolEntity(int sockfd, Server &server, GameListener gameListener) : 
         NFProtocolEntity(sockfd), 
-        server(server) 
+        server(server),
+        gameListener(std::move(gameListener))
     {}
 
 
@@ -61,24 +65,28 @@ class NFServerProtocolEntity : public NFProtocolEntity {
     void onUpdate(const Duration &dt) override {
         switch(fsm) {
             case AWAITING_GAME: {
-                if(server.gameManager.isGameReady(gameID)) {
-                    std::scoped_lock lk(server.gameManager.getGameMutex(gameID));
-                    sendFullSync(server.gameManager.getGame(gameID));
-                    knownMoveCount = 0;
+                auto seatDelay = server.botManager.config().seatDelay;
+                if(waitingForOpponent && seatDelay > 0s && Clock::now() - waitingSince >= seatDelay) {
+                    waitingForOpponent = false;
+                    server.botManager.fillGame(game.id());
+                }
+                if(game.isReady()) {
+                    waitingForOpponent = false;
+                    std::scoped_lock lk(game.mutex());
+                    sendFrame(game.snapshots().get(game.game()));
+                    // the full sync already includes all moves made so far
+                    knownBatchCount = game.journal().batches().size();
                     fsm = INGAME;
                 }
             }
             break;
 
             case INGAME: {
-                std::scoped_lock lk(server.gameManager.getGameMutex(gameID));
-                auto &globalMoves = server.gameManager.getMoveList(gameID);
-                if(globalMoves.size() > knownMoveCount) {
-                    GameIncrementalSync sync;
-                    for(; knownMoveCount < globalMoves.size(); ++knownMoveCount)
-                        sync.moveList.push_back(globalMoves[knownMoveCount]);
-                    sendIncrementalSync(sync);
-                }
+                std::scoped_lock lk(game.mutex());
+                auto &batches = game.journal().batches();
+                for(; knownBatchCount < batches.size(); ++knownBatchCount)
+                    if(batches[knownBatchCount].author != username)
+                        sendFrame(batches[knownBatchCount].frame);
             }
 
             default: break;
@@ -98,16 +106,19 @@ class NFServerProtocolEntity : public NFProtocolEntity {
 
         if(server.status() != ServerStatus::RUNNING) {
             sendGameJoinError(GameJoinError::SERVER_SHUTTING_DOWN);
-            halt();
+            haltReason = "Server shutting down.";
+            cleanupAndHalt();
+            return;
         }
 
         if(server.gameManager.findGameByPlayer(username))
             throw ProtocolError("User is already in game.");
 
-        auto error = server.gameManager.hostNewGame(username, *request.map, gameID);
+        auto error = server.gameManager.hostNewGame(username, *request.map, game, gameListener);
+        waitingForOpponent = false;
         if(error == GameJoinError::NO_ERROR) {
             fsm = AWAITING_GAME;
-            sendHostGameAck({gameID});
+            sendHostGameAck({game.id()});
         } else
             sendGameJoinError(error);
     }
@@ -118,25 +129,31 @@ class NFServerProtocolEntity : public NFProtocolEntity {
 
         if(server.status() != ServerStatus::RUNNING) {
             sendGameJoinError(GameJoinError::SERVER_SHUTTING_DOWN);
-            halt();
+            haltReason = "Server shutting down.";
+            cleanupAndHalt();
+            return;
         }
 
         if(server.gameManager.findGameByPlayer(username))
             throw ProtocolError("User is already in game.");
 
         GameJoinError error;
+        // only players looking for a random opponent get bots, never private games
+        bool joinAny = request.gameID == JoinGameRequest::JOIN_ANY;
 
-        if(request.gameID == JoinGameRequest::JOIN_ANY)
-            error = server.gameManager.joinAnyGame(username, gameID);
-        else {
-            error = server.gameManager.joinGame(username, request.gameID);
-            if(error == GameJoinError::NO_ERROR) 
-                gameID = request.gameID;
-        }
+        if(joinAny)
+            error = server.gameManager.joinAnyGame(username, game, gameListener);
+        else
+            error = server.gameManager.joinGame(username, request.gameID, game, gameListener);
 
-        if(error == GameJoinError::NO_ERROR)
+        waitingForOpponent = false;
+        if(error == GameJoinError::NO_ERROR) {
             fsm = AWAITING_GAME;
-        else
+            if(joinAny) {
+                waitingForOpponent = true;
+                waitingSince = Clock::now();
+            }
+        } else
             sendGameJoinError(error);
     }
 
@@ -145,6 +162,8 @@ class NFServerProtocolEntity : public NFProtocolEntity {
             if(fsm == INGAME)
                 sendLeaveGameRequest({});
             server.gameManager.leaveGame(username);
+            game = {};
+            waitingForOpponent = false;
             fsm = IDLE;
         } else
             throw ProtocolError("Unexpected LeaveGameRequest");
@@ -154,26 +173,33 @@ class NFServerProtocolEntity : public NFProtocolEntity {
         if(fsm != INGAME)
             return;
 
-        std::scoped_lock lk(server.gameManager.getGameMutex(gameID));
-        auto &game = server.gameManager.getGame(gameID);
-        auto &globalMoves = server.gameManager.getMoveList(gameID);
-        
-        for(auto move : sync.moveList)
-            try {
-                if(game.currentPlayer() != username)
-                    throw InvalidMoveError("Player attempted to move when it was not their turn.");
-                if(move.type == MoveType::FORCED_SURRENDER)
-                    throw InvalidMoveError("Client is not allowed to send force surrender.");
-                game.makeMove(move);
-                globalMoves.push_back(move);
-                ++knownMoveCount;
-            } catch (InvalidMoveError &e) {
-                throw ProtocolError("Invalid move: " + std::string(e.what()));
-            }
-        
+        std::scoped_lock lk(game.mutex());
+        auto &state = game.game();
+
+        if(sync.moveList.empty())
+            return;
+        if(state.currentPlayer() != username)
+            throw ProtocolError("Invalid move: Player attempted to move when it was not their turn.");
+        for(size_t i=0; i<sync.moveList.size(); ++i) {
+            if(sync.moveList[i].type == MoveType::FORCED_SURRENDER)
+                throw ProtocolError("Invalid move: Client is not allowed to send force surrender.");
+            // the rest of the batch would be made on behalf of the next player
+            if(sync.moveList[i].type == MoveType::END_TURN && i+1 != sync.moveList.size())
+                throw ProtocolError("Invalid move: Player attempted to move when it was not their turn.");
+        }
+
+        // the batch is applied all-or-nothing, so rejected batches never reach other players
+        size_t failedMove;
+        MoveStatus status = state.tryMakeMoves(sync.moveList, &failedMove);
+        if(status != MoveStatus::OK)
+            throw ProtocolError("Invalid move " + std::to_string(failedMove) + ": " + moveStatusMessage(status));
+        game.journal().publish(username, sync.moveList);
     }
 
+    /// Releases the user & game held by the connection. Every way of halting a logged in connection must go through here.
     void cleanupAndHalt() {
+        if(!isRunning())
+            return;
         if(!username.empty()) {
             if(fsm == AWAITING_GAME || fsm == INGAME)
                 server.gameManager.leaveGame(username);
@@ -198,33 +224,59 @@ class NFServerProtocolEntity : public NFProtocolEntity {
     }
 };
 
-void handleConnection(int sockfd, Server *server) {
-
-    TimePoint t0 = Clock::now();
-
+ConnectionHandler::ConnectionHandler(int sockfd, Server &server, bool directIO, GameListener wakeup) :
+    entity(std::make_unique<NFServerProtocolEntity>(sockfd, server, std::move(wakeup))),
+    sockfd(sockfd),
+    lastUpdate(Clock::now())
+{
     std::cerr << "Connection accepted (sockfd="<<sockfd<<")" << std::endl;
-    scope_exit();
+    entity->socket().setDirectIO(directIO);
+    entity->onInit();
+    entity->flushNetworkEvents();
+}
 
-    NFServerProtocolEntity entity(sockfd, *server);
-    entity.onInit();
+ConnectionHandler::~ConnectionHandler() {
+    std::cerr << "Connection terminated (sockfd="<<sockfd<<")";
+    if(!entity->haltReason.empty())
+        std::cerr << ", reason: " << entity->haltReason;
+    std::cerr << std::endl;
+}
 
-    while(entity.isRunning()) {
+void ConnectionHandler::update() {
 
-        TimePoint t1 = Clock::now();
-        Duration dt = t1 - t0;
-        t0 = t1;
+    if(!entity->isRunning())
+        return;
 
-        entity.runNetworkEvents();
-        if(!entity.isRunning())
-            break;
-        entity.onUpdate(dt);
+    TimePoint now = Clock::now();
+    Duration dt = now - lastUpdate;
+    lastUpdate = now;
 
-        sleep(10ms);
+    try {
+        entity->runNetworkEvents();
+        if(!entity->isRunning())
+            return;
+        entity->onUpdate(dt);
+        entity->flushNetworkEvents();
+    } catch(const std::exception &e) {
+        // previously this would silently kill the connection thread;
+        // now we at least need to release the user & game held by the connection
+        entity->haltReason = std::string("internal error: ") + e.what();
+        entity->cleanupAndHalt();
     }
+}
 
-    std::cerr << "Connection terminated (sockfd="<<sockfd<<")";
-    if(!entity.haltReason.empty())
-        std::cerr << ", reason: " << entity.haltReason;
-    std::cerr << std::endl;
+int ConnectionHandler::fd() const {
+    return sockfd;
 }
 
+bool ConnectionHandler::isRunning() const {
+    return entity->isRunning();
+}
+
+bool ConnectionHandler::wantsWrite() const {
+    return entity->socket().hasPendingOutput();
+}
+
+MessageSocket &ConnectionHandler::socket() {
+    return entity->socket();
+}
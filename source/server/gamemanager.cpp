@@ -4,115 +4,274 @@
 #include <cassert>
 #include <iostream>
 
-GameJoinError GameManager::hostNewGame(const std::string &username, const Map &map, GameID &outGameID) {
-    std::scoped_lock lk(mutex);
+void MoveJournal::publish(const std::string &author, const std::vector<Move> &moves) {
+    if(moves.empty())
+        return;
+    _moves.insert(_moves.end(), moves.begin(), moves.end());
+    _batches.push_back({author, NFProtocolEntity::encodeIncrementalSync({moves})});
+    for(auto &[username, listener] : listeners)
+        if(username != author)
+            listener();
+}
+
+void MoveJournal::subscribe(const std::string &username, GameListener listener) {
+    if(listener)
+        listeners[username] = std::move(listener);
+}
+
+void MoveJournal::unsubscribe(const std::string &username) {
+    listeners.erase(username);
+}
+
+void MoveJournal::notifyAll() {
+    for(auto &[username, listener] : listeners)
+        listener();
+}
+
+const std::vector<Move> &MoveJournal::moves() const {
+    return _moves;
+}
+
+const std::vector<MoveJournal::Batch> &MoveJournal::batches() const {
+    return _batches;
+}
+
+const SharedFrame &SnapshotCache::get(const Game &game) {
+    if(!snapshot || snapshotVersion != game.version()) {
+        snapshot = NFProtocolEntity::encodeFullSync(game);
+        snapshotVersion = game.version();
+    }
+    return snapshot;
+}
+
+GameHandle::GameHandle(std::shared_ptr<GameEntry> entry) :
+    entry(std::move(entry))
+{}
+
+GameHandle::operator bool() const {
+    return entry != nullptr;
+}
+
+GameID GameHandle::id() const {
+    return entry->id;
+}
+
+bool GameHandle::isReady() const {
+    return entry->ready;
+}
+
+std::mutex &GameHandle::mutex() const {
+    return entry->mutex;
+}
+
+Game &GameHandle::game() const {
+    assert(entry->ready);
+    return *entry->game;
+}
+
+MoveJournal &GameHandle::journal() const {
+    return entry->journal;
+}
+
+SnapshotCache &GameHandle::snapshots() const {
+    return entry->snapshots;
+}
+
+const std::vector<std::string> &GameHandle::players() const {
+    return entry->players;
+}
+
+// GameID layout: [generation:31][slot:32], slot = index within shard * shardCount + shard
+// (the top bit stays clear because clients treat negative IDs as invalid)
+
+GameJoinError GameManager::hostNewGame(const std::string &username, const Map &map, GameHandle &outGame, GameListener listener) {
     assert(!findGameByPlayer(username));
-    assert(&map != nullptr);
     
-    outGameID = initNewGame(map);
-    return joinGame(username, outGameID);
+    auto game = initNewGame(map);
+    auto result = enterGame(username, game, std::move(listener));
+    if(result == GameJoinError::NO_ERROR)
+        outGame = game;
+    return result;
 }
 
-GameJoinError GameManager::joinGame(const std::string &username, GameID gameID) {
-    std::scoped_lock lk(mutex);
-
+GameJoinError GameManager::joinGame(const std::string &username, GameID gameID, GameHandle &outGame, GameListener listener) {
     assert(!findGameByPlayer(username));
 
-    if(games.find(gameID) == games.end())
+    auto game = getGame(gameID);
+    if(!game)
         return GameJoinError::GAME_DOESNT_EXIST;
 
-    Entry &entry = games[gameID];
+    auto result = enterGame(username, game, std::move(listener));
+    // games waiting for random opponents can also be joined directly (e.g. by bots)
+    if(game.isReady())
+        stopMatchmaking(game.id());
+
+    if(result == GameJoinError::NO_ERROR)
+        outGame = game;
+    return result;
+}
+
+GameJoinError GameManager::joinAnyGame(const std::string &username, GameHandle &outGame, GameListener listener) {
+    assert(!findGameByPlayer(username));
+
+    // the chosen game may start or be removed before the player gets to join it, then another one is tried
+    for(;;) {
+        GameHandle game;
+        {
+            std::scoped_lock lk(matchmakingMutex);
+            if(joinableGames.empty()) {
+                std::uniform_int_distribution<int> dist(0, Map::registry.size()-1);
+                const auto &map = Map::registry[dist(rng)];
+                game = initNewGame(map);
+                joinableGames.insert(game.id());
+            } else {
+                game = getGame(*joinableGames.begin());
+                if(!game) {
+                    joinableGames.erase(joinableGames.begin());
+                    continue;
+                }
+            }
+        }
+
+        // the listener is copied, since it's still needed if the game has to be changed
+        auto result = enterGame(username, game, listener);
+        if(result == GameJoinError::GAME_ALREADY_RUNNING || result == GameJoinError::GAME_DOESNT_EXIST) {
+            stopMatchmaking(game.id());
+            continue;
+        }
+        if(game.isReady())
+            stopMatchmaking(game.id());
+
+        if(result == GameJoinError::NO_ERROR)
+            outGame = game;
+        return result;
+    }
+}
+
+GameJoinError GameManager::enterGame(const std::string &username, GameHandle game, GameListener listener) {
+    GameEntry &entry = *game.entry;
+    std::scoped_lock gameLock(entry.mutex);
+
+    if(entry.removed)
+        return GameJoinError::GAME_DOESNT_EXIST;
     if(entry.ready)
         return GameJoinError::GAME_ALREADY_RUNNING;
 
     entry.players.push_back(username);
-    if(entry.players.size() == entry.map->playerCount())
-        entry.ready = true;
-    playerGames[username] = gameID;
-
-    if(entry.ready)
-        entry.game = std::make_unique<Game>(gameID, *entry.map, entry.players);
+    {
+        PlayerShard &shard = playerShard(username);
+        std::scoped_lock lk(shard.mutex);
+        shard.playerGames[username] = entry.id;
+    }
+    entry.journal.subscribe(username, std::move(listener));
 
+    if(entry.players.size() == entry.map->playerCount()) {
+        entry.game = std::make_unique<Game>(entry.id, *entry.map, entry.players);
+        entry.ready = true;
+        entry.journal.notifyAll();
+    }
     return GameJoinError::NO_ERROR;
 }
 
-GameJoinError GameManager::joinAnyGame(const std::string &username, GameID &outGameID) {
-    std::scoped_lock lk(mutex);
-    assert(!findGameByPlayer(username));
+void GameManager::stopMatchmaking(GameID id) {
+    std::scoped_lock lk(matchmakingMutex);
+    joinableGames.erase(id);
+}
 
-    if(joinableGames.empty()) {
-        std::uniform_int_distribution<int> dist(0, Map::registry.size()-1);
-        const auto &map = Map::registry[dist(rng)];
-        joinableGames.insert(initNewGame(map));
+void GameManager::leaveGame(const std::string &username) {
+    GameID id;
+    {
+        PlayerShard &shard = playerShard(username);
+        std::scoped_lock lk(shard.mutex);
+        auto it = shard.playerGames.find(username);
+        assert(it != shard.playerGames.end());
+        id = it->second;
+        shard.playerGames.erase(it);
     }
-    auto id = *joinableGames.begin();
-    auto result = joinGame(username, id);
-    if(isGameReady(id))
-        joinableGames.erase(id);
+    auto game = getGame(id);
+    assert(game);
 
-    if(result == GameJoinError::NO_ERROR)
-        outGameID = id;
-    return result;
+    GameEntry &entry = *game.entry;
+    bool empty;
+    {
+        std::scoped_lock gameLock(entry.mutex);
+        entry.players.erase(std::find(entry.players.begin(), entry.players.end(), username));
+        entry.journal.unsubscribe(username);
+        empty = entry.players.empty();
+
+        // players leaving a game they are still playing surrender, and don't keep the others waiting for their turn to end
+        Game *running = entry.game.get();
+        if(!empty && running && !running->didPlayerWin(username) && !running->didPlayerLoose(username)) {
+            bool theirTurn = running->currentPlayer() == username;
+            std::vector<Move> moves = {Move::forceSurrender(running->getPlayerIndex(username))};
+            if(theirTurn)
+                moves.push_back(Move::endTurn());
+            for(const auto &move : moves)
+                running->makeMove(move);
+            entry.journal.publish("", moves);
+        }
+        if(empty) {
+            entry.removed = true;
+            removeGame(entry.id);
+        }
+    }
+    if(empty)
+        stopMatchmaking(entry.id);
 }
 
-void GameManager::leaveGame(const std::string &username) {
-    std::scoped_lock lk(mutex);
-
-    auto id = findGameByPlayer(username);
-    assert(id);
-    assert(games.find(id) != games.end());
-    auto &entry = games[id];
-
-    entry.players.erase(std::find(entry.players.begin(), entry.players.end(), username));
-    //TODO: if game has not ended, then make the leaving player automatically surrender
-    if(entry.players.empty()) {
-        games.erase(id);
-        if(joinableGames.find(id) != joinableGames.end())
-            joinableGames.erase(id);
-    } else {
-        entry.moveList.push_back(Move::forceSurrender(entry.game->getPlayerIndex(username)));
+GameHandle GameManager::initNewGame(const Map &map) {
+    unsigned shardIndex = nextShard++ % shardCount;
+    Shard &shard = shards[shardIndex];
+    std::scoped_lock lk(shard.mutex);
+
+    if(shard.freeSlots.empty()) {
+        shard.freeSlots.push_back(static_cast<uint32_t>(shard.slots.size()));
+        shard.slots.emplace_back();
     }
+    uint32_t index = shard.freeSlots.back();
+    shard.freeSlots.pop_back();
 
-    playerGames.erase(username);
+    Slot &slot = shard.slots[index];
+    GameID id = (static_cast<GameID>(slot.generation) << 32) | (static_cast<GameID>(index) * shardCount + shardIndex);
+    slot.entry = std::make_shared<GameEntry>(id, map);
+    return GameHandle(slot.entry);
 }
 
-GameID GameManager::initNewGame(const Map &map) {
-    auto id = nextGameID++;
-    games[id].map = &map;
-    return id;
+void GameManager::removeGame(GameID id) {
+    auto slotID = static_cast<uint32_t>(id & 0xffffffff);
+    Shard &shard = shards[slotID % shardCount];
+    std::scoped_lock lk(shard.mutex);
+
+    Slot &slot = shard.slots[slotID / shardCount];
+    slot.entry.reset();
+    slot.generation = std::max<uint32_t>((slot.generation + 1) & 0x7fffffff, 1);
+    shard.freeSlots.push_back(slotID / shardCount);
 }
 
 GameID GameManager::findGameByPlayer(const std::string &username) {
-    std::scoped_lock lk(mutex);
-    auto it = playerGames.find(username);
-    if(it == playerGames.end())
+    PlayerShard &shard = playerShard(username);
+    std::scoped_lock lk(shard.mutex);
+    auto it = shard.playerGames.find(username);
+    if(it == shard.playerGames.end())
         return 0;
     else
         return it->second;
 }
 
-bool GameManager::isGameReady(GameID id) {
-    std::scoped_lock lk(mutex);
-    auto it = games.find(id);
-    if(it == games.end())
-        return false;
-    return it->second.ready;
+GameManager::PlayerShard &GameManager::playerShard(const std::string &username) {
+    return playerShards[std::hash<std::string>()(username) % shardCount];
 }
 
-Game &GameManager::getGame(GameID id) {
-    std::scoped_lock lk(mutex);
-    assert(isGameReady(id));
-    return *games[id].game;
-}
+GameHandle GameManager::getGame(GameID id) {
+    if(id <= 0)
+        return {};
+    auto slotID = static_cast<uint32_t>(id & 0xffffffff);
+    auto generation = static_cast<uint32_t>(id >> 32);
+    Shard &shard = shards[slotID % shardCount];
+    std::scoped_lock lk(shard.mutex);
 
-std::mutex &GameManager::getGameMutex(GameID id) {
-    std::scoped_lock lk(mutex);
-    assert(isGameReady(id));
-    return games[id].gameMutex;
+    uint32_t index = slotID / shardCount;
+    if(index >= shard.slots.size() || shard.slots[index].generation != generation || !shard.slots[index].entry)
+        return {};
+    return GameHandle(shard.slots[index].entry);
 }
-
-std::vector<Move> &GameManager::getMoveList(GameID id) {
-    std::scoped_lock lk(mutex);
-    assert(isGameReady(id));
-    return games[id].moveList;
-}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include <iouring.h>
+
+#include <cstring>
+#include <system_error>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+IoUring::IoUring(unsigned entries) {
+
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    ringfd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if(ringfd == -1)
+        throw std::system_error(errno, std::generic_category(), "io_uring_setup failed");
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // kernels with IORING_FEAT_SINGLE_MMAP share one mapping for both rings
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+    if(sqRingPtr == MAP_FAILED) {
+        int error = errno;
+        close(ringfd);
+        throw std::system_error(error, std::generic_category(), "failed to mmap io_uring submission queue");
+    }
+
+    if(singleMmap)
+        cqRingPtr = sqRingPtr;
+    else {
+        cqRingPtr = mmap(nullptr, cqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringfd, IORING_OFF_CQ_RING);
+        if(cqRingPtr == MAP_FAILED) {
+            int error = errno;
+            munmap(sqRingPtr, sqRingSize);
+            close(ringfd);
+            throw std::system_error(error, std::generic_category(), "failed to mmap io_uring completion queue");
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqesPtr = mmap(nullptr, sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringfd, IORING_OFF_SQES);
+    if(sqesPtr == MAP_FAILED) {
+        int error = errno;
+        if(!singleMmap)
+            munmap(cqRingPtr, cqRingSize);
+        munmap(sqRingPtr, sqRingSize);
+        close(ringfd);
+        throw std::system_error(error, std::generic_category(), "failed to mmap io_uring submission queue entries");
+    }
+    sqes = static_cast<io_uring_sqe *>(sqesPtr);
+
+    auto sq = static_cast<uint8_t *>(sqRingPtr);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqEntries = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto cq = static_cast<uint8_t *>(cqRingPtr);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring() {
+    munmap(sqes, sqesSize);
+    if(cqRingPtr != sqRingPtr)
+        munmap(cqRingPtr, cqRingSize);
+    munmap(sqRingPtr, sqRingSize);
+    close(ringfd);
+}
+
+io_uring_sqe *IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if(sqeTail - head >= *sqEntries)
+        return nullptr;
+    io_uring_sqe *sqe = &sqes[sqeTail & *sqMask];
+    ++sqeTail;
+    memset(sqe, 0, sizeof *sqe);
+    return sqe;
+}
+
+unsigned IoUring::submitAndWait(unsigned waitNr) {
+
+    // publish the entries handed out by getSqe()
+    unsigned tail = *sqTail;
+    unsigned toSubmit = sqeTail - sqeHead;
+    for(; sqeHead != sqeTail; ++sqeHead, ++tail)
+        sqArray[tail & *sqMask] = sqeHead & *sqMask;
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+    unsigned flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while(true) {
+        int result = static_cast<int>(syscall(__NR_io_uring_enter, ringfd, toSubmit, waitNr, flags, nullptr, 0));
+        if(result >= 0)
+            return static_cast<unsigned>(result);
+        // the kernel only reports EINTR if nothing was submitted, so it's safe to retry as-is
+        if(errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+    }
+}
+
+bool IoUring::registerBuffers(const iovec *buffers, unsigned count) {
+    return syscall(__NR_io_uring_register, ringfd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
@@ -1,22 +1,21 @@
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <csignal>
 #include <cstring>
+#include <string>
 
-#include <future>
-#include <vector>
-#include <atomic>
-#include <thread>
+#include <sys/epoll.h>
 
 #include <scope_guard.h>
 #include <network/defaults.h>
 #include <util/time.h>
 #include <server.h>
-#include <connectionhandler.h>
+#include <reactor.h>
 #include <engine/content.h>
 
 volatile sig_atomic_t caughtSignal = 0;
@@ -26,11 +25,60 @@ void signalHandler(int signum) {
 
 int createServerSocket(uint16_t port, int maxQueuedConnectionRequests = 16);
 
+void printUsage(const char *programName) {
+    std::cerr << "Usage: " << programName << " [--io-backend=epoll|io_uring] [--threads=N]"
+              << " [--bot-delay=SECONDS] [--bot-threads=N] [--bot-move-time=MS] [--bot-search-threads=N]" << std::endl;
+}
+
 int main(int argc, char **argv) {
 
+    IOBackend ioBackend = IOBackend::EPOLL;
+    int threadCount = 0;
+    BotConfig botConfig;
+
+    // @returns value of "--name=N" options, or -1 if the argument isn't that option
+    auto intOption = [](const std::string &arg, const char *name) {
+        std::string prefix = std::string(name) + "=";
+        if(arg.rfind(prefix, 0) != 0)
+            return -1;
+        return atoi(arg.c_str() + prefix.size());
+    };
+
+    for(int i=1; i<argc; ++i) {
+        std::string arg = argv[i];
+        if(arg == "--io-backend=epoll")
+            ioBackend = IOBackend::EPOLL;
+        else if(arg == "--io-backend=io_uring")
+            ioBackend = IOBackend::IO_URING;
+        else if(arg.rfind("--threads=", 0) == 0 && atoi(arg.c_str() + strlen("--threads=")) > 0)
+            threadCount = atoi(arg.c_str() + strlen("--threads="));
+        else if(intOption(arg, "--bot-delay") >= 0)
+            botConfig.seatDelay = std::chrono::seconds(intOption(arg, "--bot-delay"));
+        else if(intOption(arg, "--bot-threads") > 0)
+            botConfig.threadCount = intOption(arg, "--bot-threads");
+        else if(intOption(arg, "--bot-move-time") > 0)
+            botConfig.limits.timeBudget = std::chrono::milliseconds(intOption(arg, "--bot-move-time"));
+        else if(intOption(arg, "--bot-search-threads") > 0)
+            botConfig.limits.threadCount = intOption(arg, "--bot-search-threads");
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
     std::cerr << "Registering signal handlers." << std::endl;
     signal(SIGINT, &signalHandler);
     signal(SIGQUIT, &signalHandler);
+    // a disconnecting client should only fail the write, not kill the whole server
+    signal(SIGPIPE, SIG_IGN);
+
+    // Signals stay blocked everywhere except inside epoll_pwait() in the main loop,
+    // so that they always interrupt the main thread (and never get lost in a worker).
+    sigset_t blockedSignals, originalSignalMask;
+    sigemptyset(&blockedSignals);
+    sigaddset(&blockedSignals, SIGINT);
+    sigaddset(&blockedSignals, SIGQUIT);
+    pthread_sigmask(SIG_BLOCK, &blockedSignals, &originalSignalMask);
 
     std::cerr << "Creating server socket on port " << defaultServerPort << std::endl;
     int serverSocket = createServerSocket(defaultServerPort);
@@ -38,28 +86,61 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     scope_exit(close(serverSocket));
 
-    std::vector<std::future<void>> threads;
+    int epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollfd == -1) {
+        perror("Failed to create epoll instance");
+        return EXIT_FAILURE;
+    }
+    scope_exit(close(epollfd));
+
+    epoll_event listenEvent;
+    memset(&listenEvent, 0, sizeof listenEvent);
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.fd = serverSocket;
+    if(epoll_ctl(epollfd, EPOLL_CTL_ADD, serverSocket, &listenEvent) == -1) {
+        perror("Failed to register server socket in epoll");
+        return EXIT_FAILURE;
+    }
 
     Server server;
     initGameContent();
+    server.botManager.configure(botConfig);
+
+    Reactor reactor(server, ioBackend, threadCount);
+    std::cerr << "Started " << reactor.threadCount() << " reactor threads using " 
+              << (reactor.backend() == IOBackend::IO_URING ? "io_uring" : "epoll") << std::endl;
 
     std::cerr << "Starting main loop" << std::endl;
-    while(true) {
-
-        sockaddr_in connectingAddress;
-        socklen_t connectingAddressSize = sizeof connectingAddress;
-        int newSocket = accept(serverSocket, reinterpret_cast<sockaddr*>(&connectingAddress), &connectingAddressSize);
-
-        if(newSocket != -1) {
-            threads.push_back(std::async(std::launch::async, &handleConnection, newSocket, &server));
-        } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
-            // prevent server from hogging CPU when not handling new connections
-            sleep(10ms);
-        } else {
-            perror("Failed to accept socket, shutting down.");
+    while(server.status() == ServerStatus::RUNNING) {
+
+        epoll_event event;
+        int numEvents = epoll_pwait(epollfd, &event, 1, -1, &originalSignalMask);
+
+        if(numEvents == -1 && errno != EINTR) {
+            perror("epoll_pwait failed, shutting down.");
             server.requestShutdown();
         }
 
+        // accept everything that is waiting in the queue
+        while(numEvents > 0) {
+            sockaddr_in connectingAddress;
+            socklen_t connectingAddressSize = sizeof connectingAddress;
+            int newSocket = accept4(serverSocket, reinterpret_cast<sockaddr*>(&connectingAddress), &connectingAddressSize, SOCK_CLOEXEC);
+
+            if(newSocket != -1) {
+                // game messages are small and latency sensitive, don't let Nagle's algorithm hold them back
+                int noDelay = 1;
+                setsockopt(newSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof noDelay);
+                reactor.addConnection(newSocket);
+            } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if(errno != EINTR && errno != ECONNABORTED) {
+                perror("Failed to accept socket, shutting down.");
+                server.requestShutdown();
+                break;
+            }
+        }
+
         if(auto signum = caughtSignal) {
 
             fprintf(stderr, 
@@ -69,15 +150,13 @@ int main(int argc, char **argv) {
 
             if(signum == SIGQUIT) server.requestShutdown();
             else server.requestFastShutdown();
-
-            // wait for child threads to complete
-            for(auto &child : threads)
-                child.wait();
-
-            break;
         }
     }
 
+    // wait for connections to complete
+    reactor.wakeAll();
+    reactor.join();
+
     return EXIT_SUCCESS;
 }
 
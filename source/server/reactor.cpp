@@ -0,0 +1,567 @@
+#include <reactor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include <connectionhandler.h>
+#include <iouring.h>
+#include <util/time.h>
+
+// Connections are updated at least this often, even if nothing happens on their sockets.
+// Only needed for timeouts; game state changes are pushed to the affected connections through notify().
+static constexpr Duration tickInterval = 100ms;
+
+/// Functionality shared by all I/O backends: thread, wakeups, notifications & handing over new sockets.
+class Reactor::Worker {
+    public:
+
+    Worker(Server &server) :
+        server(server)
+    {
+        wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(wakefd == -1)
+            throw std::system_error(errno, std::generic_category(), "eventfd failed");
+    }
+
+    /// Note: the thread must be joined before derived class members are destroyed.
+    virtual ~Worker() {
+        close(wakefd);
+    }
+
+    void start() {
+        thread = std::thread(&Worker::run, this);
+    }
+
+    void addConnection(int sockfd) {
+        {
+            std::scoped_lock lk(mutex);
+            pendingSockets.push_back(sockfd);
+        }
+        wake();
+    }
+
+    /** Schedules an update of a single connection, can be called from any thread.
+     *  @param key identifies the connection, its meaning depends on the I/O backend
+     */
+    void notify(uint64_t key) {
+        bool needsWake;
+        {
+            std::scoped_lock lk(mutex);
+            // if there already are notifications queued, the worker has been woken up already
+            needsWake = notifiedKeys.empty();
+            notifiedKeys.push_back(key);
+        }
+        if(needsWake)
+            wake();
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        if(write(wakefd, &one, sizeof one) == -1 && errno != EAGAIN)
+            perror("Failed to wake reactor worker");
+    }
+
+    void join() {
+        if(thread.joinable())
+            thread.join();
+    }
+
+    protected:
+
+    virtual void run() = 0;
+
+    std::vector<int> takePendingSockets() {
+        std::vector<int> sockets;
+        std::scoped_lock lk(mutex);
+        sockets.swap(pendingSockets);
+        return sockets;
+    }
+
+    std::vector<uint64_t> takeNotifiedKeys() {
+        std::vector<uint64_t> keys;
+        std::scoped_lock lk(mutex);
+        keys.swap(notifiedKeys);
+        return keys;
+    }
+
+    /// @returns true if the worker has nothing left to do and should exit.
+    bool shouldExit(size_t connectionCount) {
+        if(server.status() == ServerStatus::RUNNING || connectionCount > 0)
+            return false;
+        // new sockets are not accepted during shutdown, but there might be a few left in the queue
+        for(int sockfd : takePendingSockets())
+            close(sockfd);
+        return true;
+    }
+
+    Server &server;
+    int wakefd;
+
+    private:
+    std::thread thread;
+
+    // guarded by mutex
+    std::mutex mutex;
+    std::vector<int> pendingSockets;
+    std::vector<uint64_t> notifiedKeys;
+};
+
+class Reactor::EpollWorker : public Reactor::Worker {
+    public:
+
+    EpollWorker(Server &server) :
+        Worker(server)
+    {
+        epollfd = epoll_create1(EPOLL_CLOEXEC);
+        if(epollfd == -1)
+            throw std::system_error(errno, std::generic_category(), "epoll_create1 failed");
+
+        epoll_event event;
+        memset(&event, 0, sizeof event);
+        event.events = EPOLLIN;
+        event.data.fd = wakefd;
+        if(epoll_ctl(epollfd, EPOLL_CTL_ADD, wakefd, &event) == -1) {
+            close(epollfd);
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl failed");
+        }
+    }
+
+    ~EpollWorker() {
+        join();
+        connections.clear();
+        close(epollfd);
+    }
+
+    private:
+
+    void run() override {
+
+        constexpr int maxEvents = 64;
+        epoll_event events[maxEvents];
+        TimePoint nextTick = Clock::now() + tickInterval;
+
+        while(true) {
+
+            auto timeoutMs = std::chrono::duration_cast<std::chrono::milliseconds>(nextTick - Clock::now()).count();
+            int numEvents = epoll_wait(epollfd, events, maxEvents, static_cast<int>(std::max<decltype(timeoutMs)>(timeoutMs, 0)));
+            if(numEvents == -1) {
+                if(errno == EINTR)
+                    continue;
+                perror("epoll_wait failed, reactor worker exiting");
+                return;
+            }
+
+            for(int i=0; i<numEvents; ++i) {
+                int fd = events[i].data.fd;
+                if(fd == wakefd) {
+                    uint64_t counter;
+                    while(read(wakefd, &counter, sizeof counter) > 0);
+                    adoptPendingSockets();
+                    for(uint64_t key : takeNotifiedKeys()) {
+                        // the fd might have been reused by now, but a spurious update is harmless
+                        auto it = connections.find(static_cast<int>(key));
+                        if(it != connections.end())
+                            updateConnection(*it->second);
+                    }
+                    // server status changes are announced through wakeAll()
+                    if(server.status() != ServerStatus::RUNNING)
+                        nextTick = Clock::now();
+                } else {
+                    auto it = connections.find(fd);
+                    if(it != connections.end())
+                        updateConnection(*it->second);
+                }
+            }
+
+            if(Clock::now() >= nextTick) {
+                for(auto &[fd, connection] : connections)
+                    updateConnection(*connection);
+                nextTick = Clock::now() + tickInterval;
+            }
+
+            removeClosedConnections();
+
+            if(shouldExit(connections.size()))
+                return;
+        }
+    }
+
+    void adoptPendingSockets() {
+        for(int sockfd : takePendingSockets()) {
+            auto connection = std::make_unique<ConnectionHandler>(sockfd, server, true, [this, sockfd]{ notify(sockfd); });
+
+            epoll_event event;
+            memset(&event, 0, sizeof event);
+            event.events = EPOLLIN | EPOLLRDHUP | (connection->wantsWrite() ? uint32_t(EPOLLOUT) : 0u);
+            event.data.fd = sockfd;
+            if(epoll_ctl(epollfd, EPOLL_CTL_ADD, sockfd, &event) == -1) {
+                perror("Failed to register socket in epoll");
+                continue;
+            }
+            writeInterest[sockfd] = connection->wantsWrite();
+            connections[sockfd] = std::move(connection);
+        }
+    }
+
+    void updateConnection(ConnectionHandler &connection) {
+        connection.update();
+
+        // only ask for EPOLLOUT while there is something to send,
+        // otherwise we would spin on an always-writable socket
+        bool wantsWrite = connection.isRunning() && connection.wantsWrite();
+        bool &registered = writeInterest[connection.fd()];
+        if(wantsWrite != registered) {
+            epoll_event event;
+            memset(&event, 0, sizeof event);
+            event.events = EPOLLIN | EPOLLRDHUP | (wantsWrite ? uint32_t(EPOLLOUT) : 0u);
+            event.data.fd = connection.fd();
+            if(epoll_ctl(epollfd, EPOLL_CTL_MOD, connection.fd(), &event) == -1)
+                perror("Failed to modify socket in epoll");
+            else
+                registered = wantsWrite;
+        }
+    }
+
+    void removeClosedConnections() {
+        for(auto it = connections.begin(); it != connections.end();) {
+            if(it->second->isRunning()) {
+                ++it;
+                continue;
+            }
+            epoll_ctl(epollfd, EPOLL_CTL_DEL, it->first, nullptr);
+            writeInterest.erase(it->first);
+            it = connections.erase(it);
+        }
+    }
+
+    int epollfd;
+    std::map<int, std::unique_ptr<ConnectionHandler>> connections;
+    std::map<int, bool> writeInterest;
+};
+
+/** Performs socket I/O of all its connections through a single io_uring.
+ *
+ *  Every connection gets a slot with a fixed receive and send area inside one
+ *  buffer registered with the kernel, so the kernel doesn't have to map user pages
+ *  on every operation. Receives are kept permanently armed, sends are issued whenever
+ *  a connection has pending output, and everything queued during one loop iteration
+ *  is submitted with a single io_uring_enter() call.
+ */
+class Reactor::UringWorker : public Reactor::Worker {
+    public:
+
+    static constexpr unsigned slotCount = 1024;
+    static constexpr size_t rxAreaSize = 4096, txAreaSize = 4096;
+    static constexpr size_t slotSize = rxAreaSize + txAreaSize;
+
+    UringWorker(Server &server) :
+        Worker(server),
+        ring(std::make_unique<IoUring>(2*slotCount + 8)),
+        slots(slotCount)
+    {
+        arenaSize = slotCount * slotSize;
+        void *ptr = mmap(nullptr, arenaSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(ptr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "failed to allocate io_uring buffers");
+        arena = static_cast<uint8_t *>(ptr);
+
+        iovec buffer = {arena, arenaSize};
+        fixedBuffers = ring->registerBuffers(&buffer, 1);
+        if(!fixedBuffers)
+            perror("Failed to register io_uring buffers, using unregistered buffers instead");
+
+        for(unsigned i=0; i<slotCount; ++i)
+            freeSlots.push_back(slotCount-1-i);
+    }
+
+    ~UringWorker() {
+        join();
+        // tear down the ring first, so that no in-flight operation can touch the buffers anymore
+        ring.reset();
+        for(auto &slot : slots)
+            slot.connection.reset();
+        munmap(arena, arenaSize);
+    }
+
+    private:
+
+    enum Operation : uint64_t {
+        RECV = 0,
+        SEND = 1,
+        TICK = 2,
+        WAKE = 3
+    };
+
+    struct Slot {
+        std::unique_ptr<ConnectionHandler> connection;
+        uint32_t generation = 0;
+        bool recvInFlight = false, sendInFlight = false, shutdown = false;
+    };
+
+    // user_data layout: [operation:8][generation:24][slot:32]
+    static uint64_t userData(Operation op, uint32_t generation, uint32_t slot) {
+        return (static_cast<uint64_t>(op) << 56) | (static_cast<uint64_t>(generation & 0xffffff) << 32) | slot;
+    }
+
+    void run() override {
+
+        while(true) {
+
+            if(!tickInFlight) {
+                tickTimeout.tv_sec = 0;
+                tickTimeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(tickInterval).count();
+                io_uring_sqe *sqe = getSqe();
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->fd = -1;
+                sqe->addr = reinterpret_cast<uint64_t>(&tickTimeout);
+                sqe->len = 1;
+                sqe->user_data = userData(TICK, 0, 0);
+                tickInFlight = true;
+            }
+            if(!wakeInFlight) {
+                // a read of the non-blocking eventfd would complete right away with -EAGAIN,
+                // so the ring waits for it to become readable and it's drained afterwards
+                io_uring_sqe *sqe = getSqe();
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = wakefd;
+                sqe->poll_events = POLLIN;
+                sqe->user_data = userData(WAKE, 0, 0);
+                wakeInFlight = true;
+            }
+
+            try {
+                ring->submitAndWait(1);
+            } catch(const std::system_error &e) {
+                std::cerr << e.what() << ", reactor worker exiting" << std::endl;
+                return;
+            }
+
+            touchedSlots.clear();
+            ring->forEachCompletion([this](const io_uring_cqe &cqe){ onCompletion(cqe); });
+            std::sort(touchedSlots.begin(), touchedSlots.end());
+            touchedSlots.erase(std::unique(touchedSlots.begin(), touchedSlots.end()), touchedSlots.end());
+
+            for(uint32_t index : touchedSlots)
+                if(slots[index].connection != nullptr)
+                    slots[index].connection->update();
+
+            for(uint32_t index : touchedSlots)
+                processSlot(index);
+
+            if(shouldExit(slotCount - freeSlots.size()))
+                return;
+        }
+    }
+
+    io_uring_sqe *getSqe() {
+        io_uring_sqe *sqe = ring->getSqe();
+        if(sqe == nullptr) {
+            // submission queue full: push what we have to the kernel and try again
+            ring->submitAndWait(0);
+            sqe = ring->getSqe();
+        }
+        return sqe;
+    }
+
+    void onCompletion(const io_uring_cqe &cqe) {
+
+        auto op = static_cast<Operation>(cqe.user_data >> 56);
+        auto generation = static_cast<uint32_t>((cqe.user_data >> 32) & 0xffffff);
+        auto index = static_cast<uint32_t>(cqe.user_data & 0xffffffff);
+
+        switch(op) {
+
+            case TICK:
+                tickInFlight = false;
+                for(uint32_t i=0; i<slotCount; ++i)
+                    if(slots[i].connection != nullptr)
+                        touchedSlots.push_back(i);
+                return;
+
+            case WAKE:
+                wakeInFlight = false;
+                // drained before taking the notifications, so that later ones trigger the next poll
+                while(read(wakefd, &wakeCounter, sizeof wakeCounter) > 0);
+                adoptPendingSockets();
+                for(uint64_t key : takeNotifiedKeys()) {
+                    uint32_t slotIndex = static_cast<uint32_t>(key & 0xffffffff);
+                    if(slots[slotIndex].connection != nullptr && slots[slotIndex].generation == (key >> 32))
+                        touchedSlots.push_back(slotIndex);
+                }
+                // server status changes are announced through wakeAll()
+                if(server.status() != ServerStatus::RUNNING)
+                    for(uint32_t i=0; i<slotCount; ++i)
+                        if(slots[i].connection != nullptr)
+                            touchedSlots.push_back(i);
+                return;
+
+            default:
+                break;
+        }
+
+        Slot &slot = slots[index];
+        assert(slot.connection != nullptr && (slot.generation & 0xffffff) == generation);
+        touchedSlots.push_back(index);
+        MessageSocket &socket = slot.connection->socket();
+
+        if(op == RECV) {
+            slot.recvInFlight = false;
+            if(cqe.res > 0)
+                socket.onReceived(arena + index*slotSize, static_cast<size_t>(cqe.res));
+            else if(cqe.res == 0 || (cqe.res != -EAGAIN && cqe.res != -EINTR))
+                socket.onRemoteClosed();
+        } else {
+            slot.sendInFlight = false;
+            if(cqe.res > 0)
+                socket.onSent(static_cast<size_t>(cqe.res));
+            else if(cqe.res != -EAGAIN && cqe.res != -EINTR)
+                socket.onRemoteClosed();
+        }
+    }
+
+    void adoptPendingSockets() {
+        for(int sockfd : takePendingSockets()) {
+            if(freeSlots.empty()) {
+                std::cerr << "Reactor worker is full, rejecting connection (sockfd=" << sockfd << ")" << std::endl;
+                close(sockfd);
+                continue;
+            }
+            uint32_t index = freeSlots.back();
+            freeSlots.pop_back();
+            uint64_t key = (static_cast<uint64_t>(slots[index].generation) << 32) | index;
+            slots[index].connection = std::make_unique<ConnectionHandler>(sockfd, server, false, [this, key]{ notify(key); });
+            touchedSlots.push_back(index);
+        }
+    }
+
+    /// Queues the I/O a connection needs or releases its slot once the connection is done.
+    void processSlot(uint32_t index) {
+        Slot &slot = slots[index];
+        if(slot.connection == nullptr)
+            return;
+
+        ConnectionHandler &connection = *slot.connection;
+        uint8_t *rxArea = arena + index*slotSize, *txArea = rxArea + rxAreaSize;
+
+        if(!connection.isRunning()) {
+            if(!slot.recvInFlight && !slot.sendInFlight) {
+                slot.connection.reset();
+                slot.shutdown = false;
+                ++slot.generation;
+                freeSlots.push_back(index);
+            } else if(!slot.shutdown) {
+                // makes the kernel complete the pending receive, so that the slot can be reused
+                shutdown(connection.fd(), SHUT_RDWR);
+                slot.shutdown = true;
+            }
+            return;
+        }
+
+        // never receive more than the socket can buffer; if it's full, the next tick retries
+        size_t maxReceivedBytes = std::min(rxAreaSize, connection.socket().receiveCapacity());
+        if(!slot.recvInFlight && maxReceivedBytes > 0) {
+            io_uring_sqe *sqe = getSqe();
+            sqe->opcode = fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_RECV;
+            sqe->fd = connection.fd();
+            sqe->addr = reinterpret_cast<uint64_t>(rxArea);
+            sqe->len = static_cast<uint32_t>(maxReceivedBytes);
+            sqe->buf_index = 0;
+            sqe->user_data = userData(RECV, slot.generation, index);
+            slot.recvInFlight = true;
+        }
+
+        if(!slot.sendInFlight && connection.wantsWrite()) {
+            MessageSocket &socket = connection.socket();
+            // the send area is registered with the ring, so this is the only copy of shared frames
+            size_t numBytes = socket.copyPendingOutput(txArea, txAreaSize);
+
+            io_uring_sqe *sqe = getSqe();
+            sqe->opcode = fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_SEND;
+            sqe->fd = connection.fd();
+            sqe->addr = reinterpret_cast<uint64_t>(txArea);
+            sqe->len = static_cast<uint32_t>(numBytes);
+            sqe->buf_index = 0;
+            if(!fixedBuffers)
+                sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = userData(SEND, slot.generation, index);
+            slot.sendInFlight = true;
+        }
+    }
+
+    std::unique_ptr<IoUring> ring;
+    uint8_t *arena;
+    size_t arenaSize;
+    bool fixedBuffers;
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots, touchedSlots;
+
+    __kernel_timespec tickTimeout;
+    uint64_t wakeCounter;
+    bool tickInFlight = false, wakeInFlight = false;
+};
+
+Reactor::Reactor(Server &server, IOBackend backend, int threadCount) :
+    server(server),
+    _backend(backend)
+{
+    if(threadCount <= 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    if(_backend == IOBackend::IO_URING)
+        try {
+            IoUring probe(1);
+        } catch(const std::system_error &e) {
+            std::cerr << "io_uring unavailable (" << e.what() << "), falling back to epoll" << std::endl;
+            _backend = IOBackend::EPOLL;
+        }
+
+    for(int i=0; i<threadCount; ++i) {
+        if(_backend == IOBackend::IO_URING)
+            workers.push_back(std::make_unique<UringWorker>(server));
+        else
+            workers.push_back(std::make_unique<EpollWorker>(server));
+        workers.back()->start();
+    }
+}
+
+Reactor::~Reactor() {
+    server.requestFastShutdown();
+    wakeAll();
+    join();
+}
+
+void Reactor::addConnection(int sockfd) {
+    workers[nextWorker++ % workers.size()]->addConnection(sockfd);
+}
+
+void Reactor::wakeAll() {
+    for(auto &worker : workers)
+        worker->wake();
+}
+
+void Reactor::join() {
+    for(auto &worker : workers)
+        worker->join();
+}
+
+int Reactor::threadCount() const {
+    return static_cast<int>(workers.size());
+}
+
+IOBackend Reactor::backend() const {
+    return _backend;
+}
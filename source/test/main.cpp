@@ -0,0 +1,33 @@
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <test.h>
+#include <engine/content.h>
+
+int main(int argc, char **argv) {
+
+    initGameContent();
+
+    const std::vector<std::pair<const char *, std::function<void()>>> suites = {
+        {"movevalidation", testMoveValidation}
+    };
+
+    // with no arguments run everything, otherwise only the named suites
+    int failures = 0;
+    for(const auto &[name, run] : suites) {
+        bool selected = argc <= 1;
+        for(int i=1; i<argc; ++i)
+            selected |= strcmp(argv[i], name) == 0;
+        if(!selected)
+            continue;
+        try {
+            run();
+            std::cout << "[ OK ] " << name << std::endl;
+        } catch(const std::exception &e) {
+            std::cout << "[FAIL] " << name << ": " << e.what() << std::endl;
+            ++failures;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,56 @@
+#include <test.h>
+
+#include <vector>
+
+#include <engine/game.h>
+#include <engine/map.h>
+#include <network/txbuffer.h>
+
+static std::vector<uint8_t> serialize(const Game &game) {
+    TxBuffer tx;
+    tx << game;
+    return std::vector<uint8_t>(tx.ptr(), tx.ptr() + tx.size());
+}
+
+// an invalid move must be rejected with `expected` by both validateMove() and tryMakeMove(), leaving the game as it was
+static void checkRejected(Game &game, const Move &move, MoveStatus expected) {
+    auto before = serialize(game);
+    uint64_t version = game.version();
+
+    check(game.validateMove(move) == expected, std::string("validateMove: expected ") + moveStatusMessage(expected)
+        + ", got " + moveStatusMessage(game.validateMove(move)));
+    check(game.tryMakeMove(move) == expected, "tryMakeMove returned a different status than validateMove");
+    check(serialize(game) == before && game.version() == version, "rejected move modified the game");
+}
+
+static Move attack(const glm::ivec2 &attacker, const glm::ivec2 &target) {
+    return {MoveType::ATTACK_UNIT, {attacker.x, attacker.y, target.x, target.y}};
+}
+
+void testMoveValidation() {
+    Game game(1, Map::registry[0], {"a", "b"});
+    check(game.currentPlayerIndex() == 0, "first player should start");
+
+    std::vector<glm::ivec2> own, enemies;
+    game.occupancy(0).forEach([&](glm::ivec2 position){ own.push_back(position); });
+    game.occupancy(1).forEach([&](glm::ivec2 position){ enemies.push_back(position); });
+    check(own.size() >= 2 && !enemies.empty(), "map should have starting units");
+
+    // starting units are placed far apart, out of each other's range
+    checkRejected(game, attack(own[0], enemies[0]), MoveStatus::OUT_OF_RANGE);
+    checkRejected(game, attack(own[0], own[1]), MoveStatus::FRIENDLY_TARGET);
+
+    // an enemy right next to the attacker is a valid target
+    glm::ivec2 adjacent(-1);
+    for(glm::ivec2 offset : {glm::ivec2(1,0), glm::ivec2(-1,0), glm::ivec2(0,1), glm::ivec2(0,-1)})
+        if(game.terrain.inBounds(own[0] + offset) && !game.isTileOccupied(own[0] + offset)) {
+            adjacent = own[0] + offset;
+            break;
+        }
+    check(adjacent != glm::ivec2(-1), "starting unit should have a free neighbour");
+    Unit enemy = *game.unitAt(enemies[0]);
+    enemy.position = adjacent;
+    game.spawn(enemy);
+    check(game.validateMove(attack(own[0], adjacent)) == MoveStatus::OK, "attack on an adjacent enemy should be valid");
+    check(game.tryMakeMove(attack(own[0], adjacent)) == MoveStatus::OK, "attack on an adjacent enemy should be made");
+}